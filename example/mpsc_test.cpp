@@ -0,0 +1,130 @@
+/*
+    MIT License
+
+    Copyright (c) 2016-2020 Raúl Ramos
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include "transactional-ring-buffer-mpsc.h"
+
+using namespace std;
+using namespace chrono;
+
+/*
+    == MPSC scaling benchmark ========
+
+    - for 1, 2, 4, ... 32 producers, every producer writes MESSAGES / producers transactions of
+      MESSAGE_SIZE bytes (producer id, sequence number and filler) and a single consumer reads them all
+    - the consumer checks the per-producer ordering and reports the aggregated throughput
+    - usage: mpsc_test [total number of messages]
+*/
+
+constexpr auto MESSAGE_SIZE = 64u;
+constexpr auto MAX_PRODUCERS = 32u;
+constexpr auto BUFFER_CAPACITY = 2u * 1024u * 1024u;
+
+qcstudio::containers::mpsc_transactional_ring_buffer<uint64_t> g_rbuffer;
+
+auto run(uint32_t _producers, uint64_t _messages) -> bool {
+    const auto per_producer = _messages / _producers;
+    atomic<uint64_t> failed_writes = 0;
+    atomic<bool> go = false;
+    atomic<bool> stop = false; // the consumer gave up (wrong data): producers must not wait for room
+
+    vector<thread> producers;
+    for (auto p = 0u; p < _producers; ++p) {
+        producers.emplace_back([&, p] {
+            uint8_t filler[MESSAGE_SIZE - 2 * sizeof(uint32_t)] = {};
+            auto failed = 0ull;
+            while (!go.load(memory_order_acquire)) {
+                this_thread::yield();
+            }
+            for (auto i = 0u; i < per_producer && !stop.load(memory_order_relaxed); ) {
+                if (auto wr = g_rbuffer.try_write(i, MESSAGE_SIZE)) {
+                    wr.push_back(p, i++);
+                    wr.push_back(&filler[0], sizeof(filler));
+                } else {
+                    ++failed;
+                    this_thread::yield();
+                }
+            }
+            failed_writes += failed;
+        });
+    }
+
+    vector<uint32_t> next(_producers, 0);
+    auto failed_reads = 0ull, sum = 0ull;
+    auto ok = true;
+    auto t0 = high_resolution_clock::now();
+    go.store(true, memory_order_release);
+    for (auto read = 0ull; read < per_producer * _producers && ok; ) {
+        if (auto rd = g_rbuffer.try_read()) {
+            auto [p, p_ok] = rd.pop_front<uint32_t>();
+            auto [i, i_ok] = rd.pop_front<uint32_t>();
+            auto filler = rd.view(rd.size() - 2 * sizeof(uint32_t));
+            ok = p_ok && i_ok && filler && p < _producers && next[p]++ == i;
+            if (ok) {
+                sum += filler.first[0];
+            }
+            ++read;
+        } else {
+            ++failed_reads;
+        }
+    }
+    auto ns = duration_cast<nanoseconds>(high_resolution_clock::now() - t0).count();
+    stop.store(true, memory_order_relaxed);
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    const auto seconds = ns / 1000000000.0;
+    const auto total = per_producer * _producers;
+    cout << "producers = " << _producers
+         << ", " << total / seconds / 1000000.0 << " M transactions/sec"
+         << ", " << total * MESSAGE_SIZE / seconds / (1024.0 * 1024.0) << " MiB/sec"
+         << ", failed writes = " << failed_writes.load()
+         << ", failed reads = " << failed_reads
+         << (ok && sum == 0 ? "" : " ERROR") << endl;
+    return ok;
+}
+
+auto main(int _argc, char* _argv[]) -> int {
+    const auto messages = _argc > 1 ? strtoull(_argv[1], nullptr, 10) : 10000000ull;
+
+    if (!g_rbuffer.reserve(BUFFER_CAPACITY)) {
+        cout << "ERR: No memory!" << endl;
+        return 1;
+    }
+    cout << "Buffer capacity = " << g_rbuffer.capacity() << " bytes, message size = " << MESSAGE_SIZE << " bytes" << endl;
+
+    for (auto producers = 1u; producers <= MAX_PRODUCERS; producers *= 2) {
+        if (!run(producers, messages)) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -48,4 +48,13 @@ project "trb_test"
     targetdir ".out/%{prj.name}/%{cfg.platform}/%{cfg.buildcfg}"
     objdir ".tmp/%{prj.name}"
 
-    files { "*.cpp", "../include/*.h" }
+    files { "trb_test.cpp", "../include/*.h" }
+
+project "mpsc_test"
+    kind "ConsoleApp"
+
+    includedirs { "../include" }
+    targetdir ".out/%{prj.name}/%{cfg.platform}/%{cfg.buildcfg}"
+    objdir ".tmp/%{prj.name}"
+
+    files { "mpsc_test.cpp", "../include/*.h" }
@@ -31,7 +31,8 @@
 #include <mutex>
 #include <future>
 #include <sstream>
-#include <cstdint>
+#include <cstdlib>
+#include <cstdint>
 #include <nmmintrin.h>
 
 #include "transactional-ring-buffer.h"
@@ -41,6 +42,12 @@ using namespace chrono;
 using namespace chrono_literals;
 
 #define INTRIN_CRC32 1
+#define BUFFER_LAYOUT ring // ring, mirrored (linux only) or padded
+#define READ_VIEW     0 // zero-copy 'view'
+#define READ_CALLBACK 1 // 'pop_front' with the lambda (inlined)
+#define READ_FUNCTION 2 // 'pop_front' with a std::function (type-erased)
+#define READ_MODE READ_VIEW
+#define BLOCKING_TRANSACTIONS 0 // park the threads instead of busy-spinning on 'try_write' / 'try_read'
 
 /*
     == Helper functions ========
@@ -147,6 +154,14 @@ class internal_coutln {
 
 #define coutln internal_coutln()
 
+#if defined(BLOCKING_TRANSACTIONS) && BLOCKING_TRANSACTIONS
+#define BLOCKING_WRITE(_ts, _size) g_rbuffer.write(_ts, 100ms, _size)
+#define BLOCKING_READ()            g_rbuffer.read(100ms)
+#else
+#define BLOCKING_WRITE(_ts, _size) g_rbuffer.try_write(_ts, _size)
+#define BLOCKING_READ()            g_rbuffer.try_read()
+#endif
+
 constexpr auto operator""_KiB(unsigned long long int v) -> uint64_t { return 1024u * v; }
 constexpr auto operator""_MiB(unsigned long long int v) -> uint64_t { return 1024u * 1024u * v; }
 constexpr auto operator""_GiB(unsigned long long int v) -> uint64_t { return 1024u * 1024u * 1024u * v; }
@@ -177,7 +192,7 @@ void producer () {
         if (pc < g_data_size) {
             auto ok = false;
             auto chunk_size = min((uint32_t)dis(gen), (uint32_t)(g_data_size - pc));
-            if (auto wt = g_rbuffer.try_write(time_now())) {
+            if (auto wt = BLOCKING_WRITE(time_now(), (uint32_t)sizeof(chunk_size) + chunk_size)) {
                 if (wt.push_back(chunk_size) &&
                     wt.push_back(g_data.get() + pc, chunk_size)) {
                     pc += chunk_size;
@@ -191,7 +206,7 @@ void producer () {
                 g_failed_writes++;
             }
 
-        } else if (auto wt = g_rbuffer.try_write(time_now())) {
+        } else if (auto wt = BLOCKING_WRITE(time_now(), (uint32_t)sizeof(uint32_t))) {
             if (wt.push_back(0xFFffFFff)) {
                 break; // Final transaction
             }
@@ -222,13 +237,27 @@ void consumer() {
 
     auto t0 = high_resolution_clock::now();
     while (true) {
-        if (auto rt = g_rbuffer.try_read()) {
+        if (auto rt = BLOCKING_READ()) {
             if (auto [tsize, ok] = rt.pop_front<uint32_t>(); ok) {
                 if (tsize == 0xFFffFFff) {
                     break; // Done!
-                } else if (!rt.pop_front(tsize, process_chunk)) {
+                }
+#if READ_MODE == READ_VIEW
+                if (auto chunk = rt.view(tsize)) {
+                    process_chunk(chunk.first, chunk.first_size);
+                    process_chunk(chunk.second, chunk.second_size);
+                } else {
+                    return; // Error!
+                }
+#elif READ_MODE == READ_CALLBACK
+                if (!rt.pop_front(tsize, process_chunk)) {
                     return; // Error!
                 }
+#else
+                if (!rt.pop_front(tsize, function<void(const uint8_t*, uint32_t)>(process_chunk))) {
+                    return; // Error!
+                }
+#endif
             } else {
                 return; // Error!
             }
@@ -247,11 +276,15 @@ void consumer() {
     == Main function ========
 */
 
-auto main() -> int {
+auto main(int _argc, char* _argv[]) -> int {
 
     // Register main thread
     g_tid2str[this_thread::get_id()] = "Main";
 
+    // Optional baseline throughput (MiB/sec) of a previous build to compare against
+
+    const auto baseline = _argc > 1 ? atof(_argv[1]) : 0.0;
+
     // Allocate a big data chunk and store random numbers in it
 
     g_data_size = 420_MiB;
@@ -297,10 +330,11 @@ auto main() -> int {
     // Reserve space for the ring buffer
 
     coutln << "Creating buffer...";
-    if (!g_rbuffer.reserve((uint32_t)2_MiB)) {
+    if (!g_rbuffer.reserve((uint32_t)2_MiB, qcstudio::containers::memory_layout::BUFFER_LAYOUT)) {
         coutln << "ERR: No memory!";
         return 1;
     }
+    g_rbuffer.enable_parking(BLOCKING_TRANSACTIONS);
     coutln << "Buffer Capacity = " << (float)g_rbuffer.capacity() / 1_MiB << " MiB";
 
     // Run threads
@@ -315,7 +349,14 @@ auto main() -> int {
     coutln << "== Stats == ";
     coutln << "Number of times the producer could not write = " << dec << g_failed_writes;
     coutln << "Number of times the consumer could not read  = " << dec << g_failed_reads;
+    coutln << "Bytes skipped as padding = " << dec << g_rbuffer.padding_size() << " (" << 100.0 * g_rbuffer.padding_size() / g_data_size << "% of the data)";
     coutln << "Time elapsed  = " << dec << ns << " ns, " << ns / 1000.f << " us, " << ns / 1000000.f << " ms, " << ns / 1000000000.f << " sec";
 
+    const auto throughput = ((double)g_data_size / 1_MiB) / (ns / 1000000000.0);
+    coutln << "Throughput = " << dec << throughput << " MiB/sec";
+    if (baseline > 0.0) {
+        coutln << "Gain vs. baseline (" << baseline << " MiB/sec) = " << showpos << (throughput / baseline - 1.0) * 100.0 << noshowpos << "%";
+    }
+
     return 0;
 }
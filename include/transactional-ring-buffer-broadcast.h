@@ -0,0 +1,702 @@
+/*
+    MIT License
+
+    Copyright (c) 2016-2020 Raúl Ramos
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+/*
+    Broadcast (single-producer / multiple-consumer) variant
+
+    CREATION of a buffer shared by one PRODUCER and up to 'MAX_READERS' CONSUMERS...
+
+        qcstudio::containers::broadcast_transactional_ring_buffer<time_type> buffer;
+        buffer.reserve(8192);
+
+    Every CONSUMER subscribes its own read cursor (from its own thread, at any time)...
+
+        auto reader = buffer.subscribe();
+        if (auto rd = reader.try_read()) {
+            auto [data, ok] = rd.pop_front<int>();
+            ...
+        }
+
+    The PRODUCER writes every transaction once, as in 'transactional_ring_buffer'...
+
+        if (auto wr = buffer.try_write(now)) {
+            wr.push_back(42);
+        }
+
+    FINALLY, notice that...
+
+        - every consumer sees every transaction committed after it subscribed, in order
+        - consumers commit independently; the producer only runs out of room because of the slowest one
+        - a new reader starts at the current end of the data. Destroying the reader unsubscribes it
+        - without readers the producer never runs out of room (transactions are dropped)
+*/
+
+#pragma once
+
+#include "transactional-ring-buffer.h"
+
+#pragma push_macro("forceinline")
+#undef forceinline
+#if defined(_WIN32)
+#   define forceinline __forceinline
+#   pragma warning(disable : 4714)
+#elif defined (__clang__) || defined(__GNUC__)
+#   define forceinline __attribute__((always_inline))
+#else
+#   define forceinline inline
+#endif
+
+namespace qcstudio {
+namespace containers {
+
+    template<typename TIMESTAMP_TYPE> class broadcast_transactional_ring_buffer;
+    template<typename TIMESTAMP_TYPE> class broadcast_write_transaction;
+    template<typename TIMESTAMP_TYPE> class broadcast_read_transaction;
+    template<typename TIMESTAMP_TYPE> class broadcast_reader;
+
+    template<typename TIMESTAMP_TYPE>
+    class broadcast_transactional_ring_buffer {
+
+    public:
+
+        static constexpr uint32_t MAX_READERS = 16;
+
+        /*
+            Construction / Destruction
+
+            - same rules as 'transactional_ring_buffer::reserve' ('ring' layout only)
+            - readers must be destroyed before the buffer
+        */
+        broadcast_transactional_ring_buffer() = default;
+        ~broadcast_transactional_ring_buffer();
+
+        auto reserve(uint32_t _wanted_capacity) -> bool;
+
+        /*
+            Getters
+
+            - 'readers' is the number of subscribed readers (informative only)
+        */
+        static constexpr auto min_capacity() -> uint32_t;
+        explicit operator bool() const;
+        auto capacity() const -> uint32_t;
+        auto readers() const -> uint32_t;
+
+        /*
+            Readers
+
+            - 'subscribe' shall fail (invalid reader) if there are already 'MAX_READERS' readers
+        */
+        auto subscribe() -> broadcast_reader<TIMESTAMP_TYPE>;
+
+        /*
+            Transactions (producer only; see 'transactional_ring_buffer::try_write')
+        */
+        auto try_write(TIMESTAMP_TYPE _timestamp, uint32_t _min_size = 0) -> broadcast_write_transaction<TIMESTAMP_TYPE>;
+
+    private:
+
+        /*
+            Data layout
+
+            - configuration: only written by 'reserve'
+            - tail: published by the producer, read by all the readers
+            - cursors: one per reader, each on its own cache line. 'head' is the position consumed by the reader
+            - producer: private state. 'head_cache_' is the cached minimum of all the cursors; they are only
+              scanned when it says that there is no room
+        */
+        struct alignas(CACHE_LINE_SIZE) cursor {
+            std::atomic<uint64_t> head = ATOMIC_VAR_INIT(0);
+            std::atomic<bool> active = ATOMIC_VAR_INIT(false);
+        };
+
+        alignas(CACHE_LINE_SIZE) uint8_t* memory_ = nullptr;
+        uint32_t capacity_ = 0, capacity_mask_ = 0;
+        bool valid_ = false;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail_ = ATOMIC_VAR_INIT(0);
+
+        cursor cursors_[MAX_READERS];
+
+        alignas(CACHE_LINE_SIZE) uint64_t end_ = 0; // producer copy of 'tail_'
+        uint64_t head_cache_ = 0;
+        bool writing_ = false;
+
+        // Disallow copy, assign and move
+
+        broadcast_transactional_ring_buffer(const broadcast_transactional_ring_buffer&) = delete;
+        broadcast_transactional_ring_buffer(const broadcast_transactional_ring_buffer&&) = delete;
+        auto operator =(const broadcast_transactional_ring_buffer&) -> broadcast_transactional_ring_buffer& = delete;
+        auto operator =(broadcast_transactional_ring_buffer&&) -> broadcast_transactional_ring_buffer& = delete;
+
+        // Become a friend of transactions and readers
+
+        friend class broadcast_write_transaction<TIMESTAMP_TYPE>;
+        friend class broadcast_read_transaction<TIMESTAMP_TYPE>;
+        friend class broadcast_reader<TIMESTAMP_TYPE>;
+
+        // helpers
+
+        auto index_of(uint64_t _position) const -> uint32_t;
+        auto slowest_head() const -> uint64_t;               // producer only
+        auto writable(uint32_t _wanted) -> uint32_t;         // producer only
+        void llwrite(uint32_t _idx, const uint8_t* _src, uint32_t _size);
+        void llread (uint32_t _idx, uint8_t* _dest, uint32_t _size) const;
+        static constexpr auto header_size() -> uint32_t;
+    };
+
+    // == Reader (read cursor of one consumer) ========
+
+    template<typename TIMESTAMP_TYPE>
+    class broadcast_reader {
+
+    public:
+
+        /*
+            Getters
+
+            - 'operator bool' shall be false if the subscription failed or after 'unsubscribe'
+        */
+        explicit operator bool() const;
+        auto has_data() const -> bool;
+
+        /*
+            Construction
+
+            - readers can be moved but not copied
+            - destructor shall unsubscribe
+        */
+        broadcast_reader(const broadcast_reader& _other) = delete;
+        broadcast_reader(broadcast_reader&& _other);
+        ~broadcast_reader();
+
+        /*
+            Transactions (see 'transactional_ring_buffer::try_read'); 1 read transaction per reader at a time
+        */
+        auto try_read() -> broadcast_read_transaction<TIMESTAMP_TYPE>;
+        void unsubscribe();
+
+    private:
+
+        friend class broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>;
+        friend class broadcast_read_transaction<TIMESTAMP_TYPE>;
+
+        broadcast_reader(broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer, uint32_t _slot);
+        auto readable() -> uint32_t;
+
+        broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>* buffer_;
+        uint32_t slot_;
+        uint64_t start_ = 0;      // private copy of the cursor
+        uint64_t tail_cache_ = 0;
+        bool reading_ = false;
+    };
+
+    // == Write transaction ========
+
+    template<typename TIMESTAMP_TYPE>
+    class broadcast_write_transaction {
+
+    public:
+
+        /*
+            Getters / data operations: see 'write_transaction'
+        */
+        explicit operator bool() const;
+        auto size() const -> uint32_t;
+        auto timestamp() const -> TIMESTAMP_TYPE;
+
+        void invalidate();
+
+        broadcast_write_transaction(broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer, TIMESTAMP_TYPE _timestamp, uint32_t _min_size = 0);
+        broadcast_write_transaction(const broadcast_write_transaction& _other) = delete;
+        broadcast_write_transaction(broadcast_write_transaction&& _other);
+        ~broadcast_write_transaction();
+
+        auto push_back(const uint8_t* _data, const uint32_t _size) -> bool;
+
+        template<typename T>
+        auto push_back(const T& _data) -> bool;
+
+        template<typename T, typename ...REST>
+        auto push_back(const T& _data, REST... _rest) -> typename std::enable_if<!std::is_pointer<T>::value, int>::type;
+
+        void commit();
+
+    private:
+
+        auto can_write(uint32_t _size) -> bool;
+
+        broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>& buffer_;
+        transaction_header<TIMESTAMP_TYPE> header_;
+        uint32_t index_ = INVALID_INDEX;
+        uint32_t available_ = 0;
+    };
+
+    // == Read transaction ========
+
+    template<typename TIMESTAMP_TYPE>
+    class broadcast_read_transaction {
+
+    public:
+
+        /*
+            Getters / data operations: see 'read_transaction'
+        */
+        explicit operator bool() const;
+        auto size() const -> uint32_t;
+        auto timestamp() const -> TIMESTAMP_TYPE;
+
+        void invalidate();
+
+        broadcast_read_transaction(broadcast_reader<TIMESTAMP_TYPE>& _reader);
+        broadcast_read_transaction(const broadcast_read_transaction& _other) = delete;
+        broadcast_read_transaction(broadcast_read_transaction&& _other);
+        ~broadcast_read_transaction();
+
+        template<typename T> auto pop_front() -> std::pair<T, bool>;
+        template<typename T> auto pop_front(T& _dest) -> bool;
+
+        template<typename CALLBACK>
+        auto pop_front(uint32_t _size, CALLBACK&& _callback) -> typename std::enable_if<std::is_invocable<CALLBACK, const uint8_t*, uint32_t>::value, bool>::type;
+
+        template<typename T> auto peek() -> const T*;
+        auto view(uint32_t _size) -> ring_span<const uint8_t>;
+
+        void commit();
+
+    private:
+
+        broadcast_reader<TIMESTAMP_TYPE>& reader_;
+        transaction_header<TIMESTAMP_TYPE> header_;
+        uint32_t index_ = INVALID_INDEX;
+        uint32_t available_ = 0;
+    };
+
+    // == implementation of the buffer ========
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::~broadcast_transactional_ring_buffer() {
+        delete[] memory_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::reserve(uint32_t _wanted_capacity) -> bool {
+        if (_wanted_capacity > 0x80000000) {
+            return false;
+        }
+        auto new_capacity = min_capacity();
+        while (new_capacity < _wanted_capacity) {
+            new_capacity <<= 1;
+        }
+        if (!valid_ || new_capacity > capacity_) {
+            delete[] memory_;
+            memory_ = new uint8_t[new_capacity];
+        }
+        capacity_ = new_capacity;
+        capacity_mask_ = capacity_ - 1;
+        end_ = head_cache_ = 0;
+        tail_.store(0, std::memory_order_release);
+        valid_ = memory_ != nullptr;
+        return valid_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::subscribe() -> broadcast_reader<TIMESTAMP_TYPE> {
+        /*
+            note: the new cursor starts at the tail loaded after activating it (with a fence that pairs with the one
+                  in 'slowest_head'). Hence, a producer that has not seen it yet, or that sees the head left by a
+                  previous reader of the slot, can never overwrite data the new reader will read
+        */
+        for (auto slot = 0u; slot < MAX_READERS; ++slot) {
+            auto expected = false;
+            if (cursors_[slot].active.compare_exchange_strong(expected, true, std::memory_order_seq_cst)) {
+                return broadcast_reader<TIMESTAMP_TYPE>(*this, slot);
+            }
+        }
+        return broadcast_reader<TIMESTAMP_TYPE>(*this, INVALID_INDEX);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::try_write(TIMESTAMP_TYPE _timestamp, uint32_t _min_size) -> broadcast_write_transaction<TIMESTAMP_TYPE> {
+        return broadcast_write_transaction<TIMESTAMP_TYPE>(*this, _timestamp, _min_size);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::index_of(uint64_t _position) const -> uint32_t {
+        return (uint32_t)_position & capacity_mask_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::slowest_head() const -> uint64_t {
+        // note: heads older than one capacity can only be left by previous readers of a slot being subscribed
+        const auto oldest = end_ - std::min<uint64_t>(end_, capacity_);
+        auto ret = end_; // no readers: everything is consumed
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (auto& cursor : cursors_) {
+            if (cursor.active.load(std::memory_order_relaxed)) {
+                ret = std::min(ret, std::max(oldest, cursor.head.load(std::memory_order_acquire)));
+            }
+        }
+        return ret;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::writable(uint32_t _wanted) -> uint32_t {
+        // free bytes according to the cached minimum; only scan the cursors when that is not enough
+        auto ret = capacity_ - (uint32_t)(end_ - head_cache_);
+        if (ret < _wanted) {
+            head_cache_ = slowest_head();
+            ret = capacity_ - (uint32_t)(end_ - head_cache_);
+        }
+        return ret;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::llwrite(uint32_t _idx, const uint8_t* _src, uint32_t _size) {
+        if (_idx + _size <= capacity_) {
+            memcpy(&memory_[_idx], _src, _size);
+        } else {
+            auto first_chunk_size = capacity_ - _idx;
+            memcpy(&memory_[_idx], _src, first_chunk_size);
+            memcpy(&memory_[0], _src + first_chunk_size, _size - first_chunk_size);
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::llread(uint32_t _idx, uint8_t* _dest, uint32_t _size) const {
+        if (_idx + _size <= capacity_) {
+            memcpy(_dest, &memory_[_idx], _size);
+        } else {
+            auto first_chunk_size = capacity_ - _idx;
+            memcpy(_dest, &memory_[_idx], first_chunk_size);
+            memcpy(_dest + first_chunk_size, &memory_[0], _size - first_chunk_size);
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline constexpr auto broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::header_size() -> uint32_t {
+        return (uint32_t)(sizeof(transaction_header<TIMESTAMP_TYPE>::size) + sizeof(transaction_header<TIMESTAMP_TYPE>::timestamp));
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline constexpr auto broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::min_capacity() -> uint32_t {
+        return CACHE_LINE_SIZE;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::operator bool() const {
+        return valid_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::capacity() const -> uint32_t {
+        return capacity_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::readers() const -> uint32_t {
+        auto ret = 0u;
+        for (auto& cursor : cursors_) {
+            ret += cursor.active.load(std::memory_order_relaxed) ? 1 : 0;
+        }
+        return ret;
+    }
+
+    // == implementation of readers ========
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_reader<TIMESTAMP_TYPE>::broadcast_reader(broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer, uint32_t _slot) : buffer_(&_buffer), slot_(_slot) {
+        if (slot_ != INVALID_INDEX) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            start_ = tail_cache_ = _buffer.tail_.load(std::memory_order_acquire);
+            _buffer.cursors_[slot_].head.store(start_, std::memory_order_release);
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_reader<TIMESTAMP_TYPE>::broadcast_reader(broadcast_reader&& _other) : buffer_(_other.buffer_), slot_(_other.slot_), start_(_other.start_), tail_cache_(_other.tail_cache_), reading_(_other.reading_) {
+        _other.slot_ = INVALID_INDEX;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_reader<TIMESTAMP_TYPE>::~broadcast_reader() {
+        unsubscribe();
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void broadcast_reader<TIMESTAMP_TYPE>::unsubscribe() {
+        if (slot_ != INVALID_INDEX) {
+            buffer_->cursors_[slot_].active.store(false, std::memory_order_release);
+            slot_ = INVALID_INDEX;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_reader<TIMESTAMP_TYPE>::operator bool() const {
+        return slot_ != INVALID_INDEX;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_reader<TIMESTAMP_TYPE>::has_data() const -> bool {
+        return *this && buffer_->tail_.load(std::memory_order_acquire) != start_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_reader<TIMESTAMP_TYPE>::try_read() -> broadcast_read_transaction<TIMESTAMP_TYPE> {
+        return broadcast_read_transaction<TIMESTAMP_TYPE>(*this);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_reader<TIMESTAMP_TYPE>::readable() -> uint32_t {
+        auto ret = (uint32_t)(tail_cache_ - start_);
+        if (ret == 0) {
+            tail_cache_ = buffer_->tail_.load(std::memory_order_acquire);
+            ret = (uint32_t)(tail_cache_ - start_);
+        }
+        return ret;
+    }
+
+    // == implementation of write transactions ========
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_write_transaction<TIMESTAMP_TYPE>::broadcast_write_transaction(broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer, TIMESTAMP_TYPE _timestamp, uint32_t _min_size) : buffer_(_buffer) {
+        if (_buffer && !_buffer.writing_) {
+            header_.size = _buffer.header_size();
+            auto available = _buffer.writable(header_.size + _min_size);
+            if (available >= header_.size + _min_size) {
+                header_.timestamp = _timestamp;
+                available_ = available - header_.size;
+                _buffer.llwrite(_buffer.index_of(_buffer.end_ + sizeof(header_.size)), reinterpret_cast<const uint8_t*>(&_timestamp), sizeof(_timestamp));
+                index_ = _buffer.index_of(_buffer.end_ + header_.size);
+                _buffer.writing_ = true;
+            }
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_write_transaction<TIMESTAMP_TYPE>::broadcast_write_transaction(broadcast_write_transaction&& _other) : buffer_(_other.buffer_), header_(_other.header_), index_(_other.index_), available_(_other.available_) {
+        _other.index_ = INVALID_INDEX; // note: not 'invalidate' as the buffer is still being written by this one
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_write_transaction<TIMESTAMP_TYPE>::~broadcast_write_transaction() {
+        commit();
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void broadcast_write_transaction<TIMESTAMP_TYPE>::invalidate() {
+        if (*this) {
+            buffer_.writing_ = false;
+            index_ = INVALID_INDEX;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void broadcast_write_transaction<TIMESTAMP_TYPE>::commit() {
+        if (*this) {
+            buffer_.llwrite(buffer_.index_of(buffer_.end_), reinterpret_cast<const uint8_t*>(&header_.size), sizeof(header_.size));
+            buffer_.end_ += header_.size;
+            buffer_.tail_.store(buffer_.end_, std::memory_order_release);
+            invalidate();
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_write_transaction<TIMESTAMP_TYPE>::can_write(uint32_t _size) -> bool {
+        if (!*this) {
+            return false;
+        }
+        if (available_ < _size) {
+            available_ = buffer_.writable(header_.size + _size) - header_.size;
+        }
+        return available_ >= _size;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_write_transaction<TIMESTAMP_TYPE>::push_back(const uint8_t* _data, const uint32_t _size) -> bool {
+        if (!can_write(_size)) {
+            return false;
+        }
+        buffer_.llwrite(index_, _data, _size);
+        index_ = buffer_.index_of(index_ + _size);
+        available_ -= _size;
+        header_.size += _size;
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename T>
+    forceinline auto broadcast_write_transaction<TIMESTAMP_TYPE>::push_back(const T& _data) -> bool {
+        return push_back(reinterpret_cast<const uint8_t*>(&_data), sizeof(T));
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename T, typename ...REST>
+    forceinline auto broadcast_write_transaction<TIMESTAMP_TYPE>::push_back(const T& _item, REST... _rest) -> typename std::enable_if<!std::is_pointer<T>::value, int>::type {
+        if (!push_back(_item)) {
+            return 0;
+        }
+        return 1 + push_back(_rest...);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_write_transaction<TIMESTAMP_TYPE>::operator bool() const {
+        return index_ != INVALID_INDEX;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_write_transaction<TIMESTAMP_TYPE>::size() const -> uint32_t {
+        return header_.size - buffer_.header_size();
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_write_transaction<TIMESTAMP_TYPE>::timestamp() const -> TIMESTAMP_TYPE {
+        return header_.timestamp;
+    }
+
+    // == implementation of read transactions ========
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_read_transaction<TIMESTAMP_TYPE>::broadcast_read_transaction(broadcast_reader<TIMESTAMP_TYPE>& _reader) : reader_(_reader) {
+        if (_reader && !_reader.reading_ && _reader.readable() > 0) {
+            auto& buffer = *_reader.buffer_;
+            buffer.llread(buffer.index_of(_reader.start_),                        reinterpret_cast<uint8_t*>(&header_.size),      sizeof(header_.size));
+            buffer.llread(buffer.index_of(_reader.start_ + sizeof(header_.size)), reinterpret_cast<uint8_t*>(&header_.timestamp), sizeof(header_.timestamp));
+            index_ = buffer.index_of(_reader.start_ + buffer.header_size());
+            available_ = header_.size - buffer.header_size();
+            _reader.reading_ = true;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_read_transaction<TIMESTAMP_TYPE>::broadcast_read_transaction(broadcast_read_transaction&& _other) : reader_(_other.reader_), header_(_other.header_), index_(_other.index_), available_(_other.available_) {
+        _other.index_ = INVALID_INDEX; // note: not 'invalidate' as the reader is still being used by this one
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_read_transaction<TIMESTAMP_TYPE>::~broadcast_read_transaction() {
+        commit();
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void broadcast_read_transaction<TIMESTAMP_TYPE>::invalidate() {
+        if (*this) {
+            reader_.reading_ = false;
+            index_ = INVALID_INDEX;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void broadcast_read_transaction<TIMESTAMP_TYPE>::commit() {
+        if (*this) {
+            reader_.start_ += header_.size;
+            reader_.buffer_->cursors_[reader_.slot_].head.store(reader_.start_, std::memory_order_release);
+            invalidate();
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_read_transaction<TIMESTAMP_TYPE>::view(uint32_t _size) -> ring_span<const uint8_t> {
+        if (!*this || _size > available_) {
+            return { nullptr, 0, nullptr, 0 };
+        }
+
+        auto& buffer = *reader_.buffer_;
+        auto idx = index_;
+        index_ = buffer.index_of(index_ + _size);
+        available_ -= _size;
+
+        auto first_size = std::min(_size, buffer.capacity_ - idx);
+        if (first_size == _size) {
+            return { &buffer.memory_[idx], _size, nullptr, 0 };
+        }
+        return { &buffer.memory_[idx], first_size, &buffer.memory_[0], _size - first_size };
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename T>
+    forceinline auto broadcast_read_transaction<TIMESTAMP_TYPE>::pop_front() -> std::pair<T, bool> {
+        auto ret = std::pair<T, bool>{};
+        ret.second = pop_front(ret.first);
+        return ret;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename T>
+    forceinline auto broadcast_read_transaction<TIMESTAMP_TYPE>::pop_front(T& _dest) -> bool {
+        auto chunks = view(sizeof(T));
+        if (!chunks) {
+            return false;
+        }
+        memcpy(reinterpret_cast<uint8_t*>(&_dest), chunks.first, chunks.first_size);
+        if (chunks.second) {
+            memcpy(reinterpret_cast<uint8_t*>(&_dest) + chunks.first_size, chunks.second, chunks.second_size);
+        }
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename CALLBACK>
+    forceinline auto broadcast_read_transaction<TIMESTAMP_TYPE>::pop_front(uint32_t _size, CALLBACK&& _callback) -> typename std::enable_if<std::is_invocable<CALLBACK, const uint8_t*, uint32_t>::value, bool>::type {
+        auto chunks = view(_size);
+        if (!chunks) {
+            return false;
+        }
+        _callback(chunks.first, chunks.first_size);
+        if (chunks.second) {
+            _callback(chunks.second, chunks.second_size);
+        }
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename T>
+    forceinline auto broadcast_read_transaction<TIMESTAMP_TYPE>::peek() -> const T* {
+        static_assert(std::is_pod<T>::value, "Only POD types can be peeked");
+        auto& buffer = *reader_.buffer_;
+        if (!*this || sizeof(T) > available_ || index_ + sizeof(T) > buffer.capacity_) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(&buffer.memory_[index_]);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline broadcast_read_transaction<TIMESTAMP_TYPE>::operator bool() const {
+        return index_ != INVALID_INDEX;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_read_transaction<TIMESTAMP_TYPE>::size() const -> uint32_t {
+        return header_.size - broadcast_transactional_ring_buffer<TIMESTAMP_TYPE>::header_size();
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto broadcast_read_transaction<TIMESTAMP_TYPE>::timestamp() const -> TIMESTAMP_TYPE {
+        return header_.timestamp;
+    }
+
+} // namespace qcstudio
+} // namespace containers
+
+#pragma pop_macro("forceinline")
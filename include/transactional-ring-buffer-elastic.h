@@ -0,0 +1,306 @@
+/*
+    MIT License
+
+    Copyright (c) 2016-2020 Raúl Ramos
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+/*
+    Elastic buffer
+
+    A buffer that grows by chaining segments (buffers of the same capacity) instead of failing 'try_write'...
+
+        qcstudio::containers::elastic_transactional_ring_buffer<time_type> buffer;
+        buffer.reserve(4096, 16); // segments of 4KiB, up to 16 of them
+
+        if (auto wr = buffer.try_write(now, sizeof(int))) { // same transactions as the plain buffer
+            wr.push_back(42);
+        }
+        ...
+        if (auto rd = buffer.try_read()) {
+            ...
+        }
+
+    FINALLY, notice that...
+
+        - while one segment is enough, transactions go straight to it: the chain is only touched when
+          'try_write' / 'try_read' fail
+        - the producer links a new segment when the current one cannot hold a new transaction of '_min_size'
+          bytes of payload. Open transactions never move: size them with '_min_size'
+        - the consumer follows the links once a segment is drained and gives it back to the pool, where the
+          producer takes it from the next time it grows ('trim' frees the pooled segments)
+        - the pool is protected by a mutex, only used when a segment is linked, drained or trimmed
+        - 'resize' changes the capacity of a live buffer with the same hand-off: the producer links a segment
+          of the new capacity and moves on, the consumer drains the old segments and frees them
+        - every segment uses the buffer's 'SIZE_TYPE' (see 'size_traits'), hence so do the capacities and sizes
+*/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "transactional-ring-buffer.h"
+
+#pragma push_macro("forceinline")
+#undef forceinline
+#if defined(_WIN32)
+#   define forceinline __forceinline
+#   pragma warning(disable : 4714)
+#elif defined (__clang__) || defined(__GNUC__)
+#   define forceinline __attribute__((always_inline))
+#else
+#   define forceinline inline
+#endif
+
+namespace qcstudio {
+namespace containers {
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    class elastic_transactional_ring_buffer {
+
+    public:
+
+        /*
+            Construction
+
+            - 'reserve' allocates the first segment with the same rules as 'transactional_ring_buffer::reserve'.
+              '_max_segments' (at least 1) caps the number of segments alive, in use or pooled
+            - it must be called before any transaction; called again it drops all the data
+        */
+        elastic_transactional_ring_buffer() = default;
+
+        auto reserve(SIZE_TYPE _wanted_capacity, uint32_t _max_segments, memory_layout _layout = memory_layout::ring) -> bool;
+
+        /*
+            Getters
+
+            - 'capacity' is the capacity of the new segments
+            - 'segments' is the number of segments allocated (in use or pooled)
+        */
+        explicit operator bool() const;
+        auto capacity() const -> SIZE_TYPE;
+        auto segments() const -> uint32_t;
+
+        /*
+            Transactions (see 'transactional_ring_buffer')
+
+            - 'try_write' only fails when a new transaction does not fit in the current segment and no more
+              segments can be linked (or a write transaction is in progress)
+            - 'trim' (any side) frees the segments in the pool
+            - 'resize' (producer only, while the consumer runs) links a segment of the new capacity (rounded as in
+              'reserve') where the next transactions go, and frees the pool. It ignores the cap of segments (the
+              old ones are freed as they are drained). It shall fail if a write transaction is in progress or
+              the memory cannot be allocated
+        */
+        auto try_write(TIMESTAMP_TYPE _timestamp, SIZE_TYPE _min_size = 0) -> write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+        auto try_read() -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+        void trim();
+        auto resize(SIZE_TYPE _wanted_capacity) -> bool;
+
+    private:
+
+        struct segment {
+            transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE> buffer;
+            std::atomic<segment*> next = ATOMIC_VAR_INIT(nullptr); // published by the producer when it moves on
+        };
+
+        auto grow(TIMESTAMP_TYPE _timestamp, SIZE_TYPE _min_size) -> write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>; // producer only
+        auto follow() -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;                                             // consumer only
+        void erase(segment* _segment);                                                                  // under 'mutex_'
+
+        // configuration / pool
+        std::atomic<SIZE_TYPE> capacity_ = ATOMIC_VAR_INIT(0); // written by 'resize'
+        uint32_t max_segments_ = 0;
+        memory_layout layout_ = memory_layout::ring;
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<segment>> segments_; // all of them
+        std::vector<segment*> pool_;
+
+        alignas(CACHE_LINE_SIZE) segment* tail_ = nullptr; // producer segment
+        alignas(CACHE_LINE_SIZE) segment* head_ = nullptr; // consumer segment
+
+        // Disallow copy and assign
+
+        elastic_transactional_ring_buffer(const elastic_transactional_ring_buffer&) = delete;
+        auto operator =(const elastic_transactional_ring_buffer&) -> elastic_transactional_ring_buffer& = delete;
+    };
+
+    // == implementation ========
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::reserve(SIZE_TYPE _wanted_capacity, uint32_t _max_segments, memory_layout _layout) -> bool {
+        auto first = std::unique_ptr<segment>(new segment);
+        if (_max_segments == 0 || !first->buffer.reserve(_wanted_capacity, _layout)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_.store(first->buffer.capacity(), std::memory_order_relaxed);
+        max_segments_ = _max_segments;
+        layout_ = _layout;
+        pool_.clear();
+        segments_.clear();
+        head_ = tail_ = first.get();
+        segments_.push_back(std::move(first));
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::operator bool() const {
+        return tail_ != nullptr;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::capacity() const -> SIZE_TYPE {
+        return capacity_.load(std::memory_order_relaxed);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::segments() const -> uint32_t {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return (uint32_t)segments_.size();
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::try_write(TIMESTAMP_TYPE _timestamp, SIZE_TYPE _min_size) -> write_transaction<TIMESTAMP_TYPE, SIZE_TYPE> {
+        auto wr = tail_->buffer.try_write(_timestamp, _min_size);
+        if (wr || tail_->buffer.writing_) {
+            return wr;
+        }
+        return grow(_timestamp, _min_size);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::try_read() -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE> {
+        auto rd = head_->buffer.try_read();
+        if (rd || head_->buffer.reading_) {
+            return rd;
+        }
+        return follow();
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    auto elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::grow(TIMESTAMP_TYPE _timestamp, SIZE_TYPE _min_size) -> write_transaction<TIMESTAMP_TYPE, SIZE_TYPE> {
+        // take a segment from the pool (or allocate one) and write there
+        segment* next = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!pool_.empty()) {
+                next = pool_.back();
+                pool_.pop_back();
+            } else if (segments_.size() < max_segments_) {
+                auto fresh = std::unique_ptr<segment>(new segment);
+                if (fresh->buffer.reserve(capacity(), layout_)) {
+                    next = fresh.get();
+                    segments_.push_back(std::move(fresh));
+                }
+            }
+        }
+        if (!next) {
+            return tail_->buffer.try_write(_timestamp, _min_size); // invalid (full)
+        }
+
+        next->next.store(nullptr, std::memory_order_relaxed);
+        next->buffer.reserve(capacity(), layout_); // recycled: reset the positions (same capacity, no allocation)
+        auto wr = next->buffer.try_write(_timestamp, _min_size);
+        if (!wr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pool_.push_back(next); // too big for any segment
+            return wr;
+        }
+
+        // everything written to the current segment must be visible before the link
+        tail_->buffer.flush();
+        tail_->next.store(next, std::memory_order_release);
+        tail_ = next;
+        return wr;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    auto elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::follow() -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE> {
+        auto next = head_->next.load(std::memory_order_acquire);
+        if (!next) {
+            return head_->buffer.try_read(); // invalid (empty)
+        }
+        if (head_->buffer.has_data()) {
+            return head_->buffer.try_read(); // published right before the link
+        }
+
+        // drained: the producer will never write to it again
+        auto drained = head_;
+        head_ = next;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (drained->buffer.capacity() == capacity()) {
+                pool_.push_back(drained);
+            } else {
+                erase(drained); // left behind by 'resize'
+            }
+        }
+        return try_read();
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    auto elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::resize(SIZE_TYPE _wanted_capacity) -> bool {
+        if (!tail_ || tail_->buffer.writing_) {
+            return false;
+        }
+        auto fresh = std::unique_ptr<segment>(new segment);
+        if (!fresh->buffer.reserve(_wanted_capacity, layout_)) {
+            return false;
+        }
+
+        auto next = fresh.get();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            capacity_.store(next->buffer.capacity(), std::memory_order_relaxed);
+            segments_.push_back(std::move(fresh));
+            for (auto pooled : pool_) {
+                erase(pooled);
+            }
+            pool_.clear();
+        }
+
+        // same hand-off as 'grow'
+        tail_->buffer.flush();
+        tail_->next.store(next, std::memory_order_release);
+        tail_ = next;
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::erase(segment* _segment) {
+        segments_.erase(std::find_if(segments_.begin(), segments_.end(), [_segment](const std::unique_ptr<segment>& _owned) { return _owned.get() == _segment; }));
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    void elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::trim() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto pooled : pool_) {
+            erase(pooled);
+        }
+        pool_.clear();
+    }
+
+} // namespace qcstudio
+} // namespace containers
+
+#pragma pop_macro("forceinline")
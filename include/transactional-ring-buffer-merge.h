@@ -0,0 +1,278 @@
+/*
+    MIT License
+
+    Copyright (c) 2016-2020 Raúl Ramos
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+/*
+    Timestamp-ordered merge of many buffers
+
+    The CONSUMER of several buffers reads all of them in timestamp order...
+
+        qcstudio::containers::merge_reader<time_type> merge;
+        merge.add(buffer_a);
+        merge.add(buffer_b);
+        merge.set_max_lag(1ms); // optional watermark
+
+        if (auto rd = merge.try_read()) {
+            auto source = merge.source(); // 0 => buffer_a, 1 => buffer_b
+            ...
+        }
+
+    FINALLY, notice that...
+
+        - the merge reader is the consumer of all its buffers (nobody else can read from them)
+        - only the headers are peeked ('next_timestamp'); the order is kept by a tournament tree with one
+          leaf per buffer, so every read replays a single path (log N comparisons)
+        - a transaction is only handed out when every buffer has data (otherwise an empty one could still
+          receive an older transaction). With 'set_max_lag' a buffer that stays empty holds back the output
+          for at most that time; transactions arriving late to it are handed out as soon as they are seen
+        - the empty buffers are kept apart, newest first: a read only probes the ones that can still hold back
+          the output plus one of those past the watermark (all of them when there is nothing else to read)
+        - ties are resolved in favour of the buffer added first
+*/
+
+#pragma once
+
+#include <vector>
+#include "transactional-ring-buffer.h"
+
+#pragma push_macro("forceinline")
+#undef forceinline
+#if defined(_WIN32)
+#   define forceinline __forceinline
+#   pragma warning(disable : 4714)
+#elif defined (__clang__) || defined(__GNUC__)
+#   define forceinline __attribute__((always_inline))
+#else
+#   define forceinline inline
+#endif
+
+namespace qcstudio {
+namespace containers {
+
+    template<typename TIMESTAMP_TYPE>
+    class merge_reader {
+
+    public:
+
+        /*
+            Construction
+
+            - 'add' must be called before any read. It shall fail if the buffer is not valid
+            - 'set_max_lag' bounds the time a buffer without data can hold back the others (forever by default)
+        */
+        merge_reader() = default;
+        merge_reader(const merge_reader&) = delete;
+        auto operator =(const merge_reader&) -> merge_reader& = delete;
+
+        auto add(transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer) -> bool;
+        void set_max_lag(std::chrono::nanoseconds _max_lag);
+
+        /*
+            Getters
+
+            - 'size' is the number of buffers
+            - 'source' is the index (order of 'add') of the buffer of the last read transaction
+        */
+        auto size() const -> uint32_t;
+        auto source() const -> uint32_t;
+
+        /*
+            Transactions
+
+            - 'try_read' shall fail if there is no data or if an empty buffer can still hold back the output
+            - the previous transaction must be committed or invalidated before the next 'try_read'
+        */
+        auto try_read() -> read_transaction<TIMESTAMP_TYPE>;
+
+    private:
+
+        using time_point = std::chrono::steady_clock::time_point;
+
+        struct leaf {
+            TIMESTAMP_TYPE timestamp;
+            bool has_data;
+            time_point empty_since;
+        };
+
+        auto wins(uint32_t _a, uint32_t _b) const -> bool;
+        auto refresh(uint32_t _input, time_point _now) -> bool;
+        void replay(uint32_t _input);
+        auto lagging(time_point _now) const -> bool;
+        void probe(time_point _now);
+
+        std::vector<transactional_ring_buffer<TIMESTAMP_TYPE>*> inputs_;
+        std::vector<leaf> leaves_;
+        std::vector<uint32_t> tree_;  // tournament tree: tree_[1] is the winner, the leaves start at 'tree_.size() / 2'
+        std::vector<uint32_t> empty_; // leaves without data; the ones within the watermark at the back in 'empty_since' order
+        uint32_t probe_ = 0;          // next leaf of 'empty_' past the watermark to probe
+        uint32_t pending_ = INVALID_INDEX; // input of the last transaction (its leaf is refreshed on the next read)
+        uint32_t source_ = INVALID_INDEX;
+        std::chrono::nanoseconds max_lag_ = std::chrono::nanoseconds::max();
+        transactional_ring_buffer<TIMESTAMP_TYPE> none_; // invalid buffer used to return invalid transactions
+    };
+
+    // == implementation ========
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto merge_reader<TIMESTAMP_TYPE>::add(transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer) -> bool {
+        if (!_buffer) {
+            return false;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        inputs_.push_back(&_buffer);
+        leaves_.push_back({ TIMESTAMP_TYPE{}, false, now });
+        empty_.push_back(size() - 1);
+
+        // rebuild the tree; unused leaves point past the inputs (they always lose)
+        auto leaves = 1u;
+        while (leaves < inputs_.size()) {
+            leaves <<= 1;
+        }
+        tree_.assign(2 * leaves, size());
+        for (auto i = 0u; i < size(); ++i) {
+            tree_[leaves + i] = i;
+        }
+        for (auto node = leaves - 1; node > 0; --node) {
+            tree_[node] = wins(tree_[2 * node], tree_[2 * node + 1]) ? tree_[2 * node] : tree_[2 * node + 1];
+        }
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void merge_reader<TIMESTAMP_TYPE>::set_max_lag(std::chrono::nanoseconds _max_lag) {
+        max_lag_ = _max_lag;
+        for (auto& leaf : leaves_) {
+            leaf.empty_since = std::chrono::steady_clock::now(); // not tracked without a watermark
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto merge_reader<TIMESTAMP_TYPE>::size() const -> uint32_t {
+        return (uint32_t)inputs_.size();
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto merge_reader<TIMESTAMP_TYPE>::source() const -> uint32_t {
+        return source_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto merge_reader<TIMESTAMP_TYPE>::try_read() -> read_transaction<TIMESTAMP_TYPE> {
+        const auto now = max_lag_ != std::chrono::nanoseconds::max() ? std::chrono::steady_clock::now() : time_point{};
+
+        if (inputs_.empty()) {
+            return none_.try_read();
+        }
+
+        // the last winner is the only leaf with data that changes
+        if (pending_ != INVALID_INDEX) {
+            if (!refresh(pending_, now)) {
+                empty_.push_back(pending_);
+            }
+            pending_ = INVALID_INDEX;
+        }
+
+        // the newest empty buffers hold back the output; the first one still empty stops the read
+        while (lagging(now)) {
+            if (!refresh(empty_.back(), now)) {
+                return none_.try_read();
+            }
+            empty_.pop_back();
+        }
+        probe(now);
+
+        auto winner = tree_[1];
+        if (!leaves_[winner].has_data) {
+            return none_.try_read();
+        }
+
+        pending_ = source_ = winner;
+        return inputs_[winner]->try_read();
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto merge_reader<TIMESTAMP_TYPE>::wins(uint32_t _a, uint32_t _b) const -> bool {
+        // buffers with data win; then the oldest timestamp; then the first added
+        if (_b >= size() || !leaves_[_b].has_data) {
+            return true;
+        }
+        if (_a >= size() || !leaves_[_a].has_data) {
+            return false;
+        }
+        return !(leaves_[_b].timestamp < leaves_[_a].timestamp);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto merge_reader<TIMESTAMP_TYPE>::refresh(uint32_t _input, time_point _now) -> bool {
+        // the caller keeps 'empty_' up to date
+        auto& leaf = leaves_[_input];
+        auto had_data = leaf.has_data;
+        leaf.has_data = inputs_[_input]->next_timestamp(leaf.timestamp);
+        if (had_data && !leaf.has_data) {
+            leaf.empty_since = _now;
+        }
+        if (had_data || leaf.has_data) {
+            replay(_input);
+        }
+        return leaf.has_data;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void merge_reader<TIMESTAMP_TYPE>::replay(uint32_t _input) {
+        for (auto node = (uint32_t)(tree_.size() / 2 + _input) / 2; node > 0; node /= 2) {
+            auto a = tree_[2 * node], b = tree_[2 * node + 1];
+            tree_[node] = wins(a, b) ? a : b;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto merge_reader<TIMESTAMP_TYPE>::lagging(time_point _now) const -> bool {
+        // true if some empty buffer can still receive a transaction older than the winner (the newest is enough)
+        if (empty_.empty()) {
+            return false;
+        }
+        return max_lag_ == std::chrono::nanoseconds::max() || _now - leaves_[empty_.back()].empty_since < max_lag_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void merge_reader<TIMESTAMP_TYPE>::probe(time_point _now) {
+        // the empty buffers past the watermark are probed round-robin, one per read, or all if nothing is left
+        auto budget = leaves_[tree_[1]].has_data ? 1u : (uint32_t)empty_.size();
+        for (; budget && !empty_.empty(); --budget) {
+            if (probe_ >= empty_.size()) {
+                probe_ = 0;
+            }
+            if (refresh(empty_[probe_], _now)) {
+                empty_[probe_] = empty_.back(); // all of them are past the watermark: the order no longer matters
+                empty_.pop_back();
+            } else {
+                ++probe_;
+            }
+        }
+    }
+
+} // namespace qcstudio
+} // namespace containers
+
+#pragma pop_macro("forceinline")
@@ -0,0 +1,676 @@
+/*
+    MIT License
+
+    Copyright (c) 2016-2020 Raúl Ramos
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+/*
+    Multi-producer / single-consumer variant
+
+    CREATION of a buffer shared by any number of PRODUCERS and one CONSUMER...
+
+        qcstudio::containers::mpsc_transactional_ring_buffer<time_type> buffer;
+        buffer.reserve(8192);
+
+    On ANY PRODUCER thread (the maximum payload size must be known upfront)...
+
+        if (auto wr = buffer.try_write(now, 64)) {
+            wr.push_back(42);
+            ...
+        }
+
+    On the CONSUMER side, the same as the single-producer buffer...
+
+        if (auto rd = buffer.try_read()) {
+            auto [data, ok] = rd.pop_front<int>();
+            ...
+        }
+
+    Differences with 'transactional_ring_buffer'...
+
+        - producers claim '_max_size' bytes of payload when the transaction is created (a CAS on the tail)
+          so transactions of different producers never interleave. Unused bytes are skipped by the consumer
+        - every transaction carries a commit flag that is set when it is committed or invalidated, so a slow
+          producer can keep its transaction open without blocking the others from writing (the consumer
+          stops at the first uncommitted transaction, though)
+        - transactions never cross the end of the buffer (as the 'padded' layout)
+        - the consumer zeroes the memory it consumes (a zero flag means 'not committed yet')
+*/
+
+#pragma once
+
+#include "transactional-ring-buffer.h"
+
+#pragma push_macro("forceinline")
+#undef forceinline
+#if defined(_WIN32)
+#   define forceinline __forceinline
+#   pragma warning(disable : 4714)
+#elif defined (__clang__) || defined(__GNUC__)
+#   define forceinline __attribute__((always_inline))
+#else
+#   define forceinline inline
+#endif
+
+namespace qcstudio {
+namespace containers {
+
+    template<typename TIMESTAMP_TYPE> class mpsc_transactional_ring_buffer;
+    template<typename TIMESTAMP_TYPE> class mpsc_write_transaction;
+    template<typename TIMESTAMP_TYPE> class mpsc_read_transaction;
+
+    template<typename TIMESTAMP_TYPE>
+    class mpsc_transactional_ring_buffer {
+
+    public:
+
+        /*
+            Construction / Destruction
+
+            - The default construction allocates NO MEMORY and sets the buffer as non-valid
+            - The destructor FREES owned memory (not borrowed memory)
+            - 'reserve' / 'borrow' follow the same rules as 'transactional_ring_buffer' (ring layout only)
+              The capacity cannot exceed 'max_capacity'
+            - 'borrow' zeroes the memory
+        */
+        mpsc_transactional_ring_buffer() = default;
+        ~mpsc_transactional_ring_buffer();
+
+        auto reserve(uint32_t _wanted_capacity) -> bool;
+        auto borrow(uint8_t* _memory, uint32_t _capacity) -> bool;
+
+        /*
+            Getters
+
+            - 'has_data' must be called from the consumer only. It is true if the next transaction is committed
+            - 'size' is a debug function (it includes claimed transactions that are not committed yet)
+        */
+        static constexpr auto min_capacity() -> uint32_t;
+        static constexpr auto max_capacity() -> uint32_t;
+        auto has_data() const -> bool;
+        auto size() const -> uint32_t;
+        explicit operator bool() const;
+        auto capacity() const -> uint32_t;
+
+        /*
+            Transactions
+
+            - 'try_write' can be called concurrently by any number of producers. It shall fail if there is no
+              room for '_max_size' bytes of payload (plus header); the transaction cannot grow beyond that.
+              When it does not fit before the end of the buffer, the bytes up to the end are claimed as padding
+              and it fits at the beginning once the consumer has skipped them
+            - 'try_read' shall be called by the consumer only (1 read transaction at a time)
+        */
+        auto try_write(TIMESTAMP_TYPE _timestamp, uint32_t _max_size) -> mpsc_write_transaction<TIMESTAMP_TYPE>;
+        auto try_read()                                               -> mpsc_read_transaction<TIMESTAMP_TYPE>;
+
+    private:
+
+        /*
+            Data layout
+
+            - configuration: only written by 'reserve' / 'borrow'
+            - tail: claimed position (CAS by the producers)
+            - head: consumed position (published by the consumer)
+            - consumer: private state of the consumer
+
+            Each transaction starts with a 32-bit state word ('COMMITTED' | 'SKIP' | claimed size) which is the
+            only synchronization between producers and the consumer; the tail is never read by the consumer.
+        */
+
+        static constexpr uint32_t COMMITTED = 0x80000000;
+        static constexpr uint32_t SKIP      = 0x40000000; // padding or invalidated transaction
+        static constexpr uint32_t SIZE_MASK = 0x3FFFFFFF;
+        static constexpr uint32_t ALIGNMENT = 8;          // of every transaction (the state word is atomic)
+
+        alignas(CACHE_LINE_SIZE) uint8_t* memory_ = nullptr;
+        uint32_t capacity_ = 0, capacity_mask_ = 0;
+        bool valid_ = false;
+        bool own_memory_ = true;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail_ = ATOMIC_VAR_INIT(0);
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head_ = ATOMIC_VAR_INIT(0);
+        alignas(CACHE_LINE_SIZE) uint64_t start_ = 0; // consumer copy of 'head_'
+        bool reading_ = false;
+
+        // Disallow copy, assign and move
+
+        mpsc_transactional_ring_buffer(const mpsc_transactional_ring_buffer&) = delete;
+        mpsc_transactional_ring_buffer(const mpsc_transactional_ring_buffer&&) = delete;
+        auto operator =(const mpsc_transactional_ring_buffer&) -> mpsc_transactional_ring_buffer& = delete;
+        auto operator =(mpsc_transactional_ring_buffer&&) -> mpsc_transactional_ring_buffer& = delete;
+
+        // Become a friend of transactions
+
+        friend class mpsc_write_transaction<TIMESTAMP_TYPE>;
+        friend class mpsc_read_transaction<TIMESTAMP_TYPE>;
+
+        // helpers
+
+        void set_buffer(uint8_t* _memory, uint32_t _capacity);
+        void free_memory();
+        auto index_of(uint64_t _position) const -> uint32_t;
+        auto state(uint32_t _index) const -> std::atomic<uint32_t>&;
+        auto claim(uint32_t _size, uint32_t& _index) -> bool;     // producers
+        void publish(uint32_t _index, uint32_t _state);           // producers
+        auto next_committed() -> uint32_t;                        // consumer only
+        void release(uint32_t _size);                             // consumer only
+        static constexpr auto header_size() -> uint32_t;
+        static constexpr auto align(uint32_t _size) -> uint32_t;
+    };
+
+    // == Write transaction ========
+
+    template<typename TIMESTAMP_TYPE>
+    class mpsc_write_transaction {
+
+    public:
+
+        /*
+            Getters (see 'transaction_base')
+
+            - 'capacity' is the payload size claimed by 'try_write'
+        */
+        explicit operator bool() const;
+        auto size() const -> uint32_t;
+        auto capacity() const -> uint32_t;
+        auto timestamp() const -> TIMESTAMP_TYPE;
+
+        /*
+            prevent the transaction from committing (the claimed room is skipped by the consumer)
+        */
+        void invalidate();
+
+        /*
+            Construction
+
+            - write transactions can be moved but not copied
+            - destructor shall commit changes
+        */
+        mpsc_write_transaction(mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer, TIMESTAMP_TYPE _timestamp, uint32_t _max_size);
+        mpsc_write_transaction(const mpsc_write_transaction& _other) = delete;
+        mpsc_write_transaction(mpsc_write_transaction&& _other);
+        ~mpsc_write_transaction();
+
+        /*
+            Data operations (same as 'write_transaction' but limited to the claimed size)
+        */
+        auto push_back(const uint8_t* _data, const uint32_t _size) -> bool;
+
+        template<typename T>
+        auto push_back(const T& _data) -> bool;
+
+        template<typename T, typename ...REST>
+        auto push_back(const T& _data, REST... _rest) -> typename std::enable_if<!std::is_pointer<T>::value, int>::type;
+
+        void commit();
+
+    private:
+
+        mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>& buffer_;
+        TIMESTAMP_TYPE timestamp_;
+        uint32_t record_ = INVALID_INDEX; // index of the transaction (until it is published)
+        uint32_t claimed_ = 0;            // total bytes claimed (header included)
+        uint32_t size_ = 0;               // payload bytes written so far
+        bool valid_ = false;
+    };
+
+    // == Read transaction ========
+
+    template<typename TIMESTAMP_TYPE>
+    class mpsc_read_transaction {
+
+    public:
+
+        /*
+            Getters (see 'transaction_base')
+        */
+        explicit operator bool() const;
+        auto size() const -> uint32_t;
+        auto timestamp() const -> TIMESTAMP_TYPE;
+
+        /*
+            prevent the transaction from committing (it stays in the buffer)
+        */
+        void invalidate();
+
+        /*
+            Construction
+
+            - read transactions can be moved but not copied
+            - destructor shall commit changes
+        */
+        mpsc_read_transaction(mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer);
+        mpsc_read_transaction(const mpsc_read_transaction& _other) = delete;
+        mpsc_read_transaction(mpsc_read_transaction&& _other);
+        ~mpsc_read_transaction();
+
+        /*
+            Data operations (same as 'read_transaction'; data is always contiguous so callbacks are called once
+            and 'view' never has a second chunk)
+        */
+        template<typename T> auto pop_front() -> std::pair<T, bool>;
+        template<typename T> auto pop_front(T& _dest) -> bool;
+
+        template<typename CALLBACK>
+        auto pop_front(uint32_t _size, CALLBACK&& _callback) -> typename std::enable_if<std::is_invocable<CALLBACK, const uint8_t*, uint32_t>::value, bool>::type;
+
+        template<typename T> auto peek() -> const T*;
+        auto view(uint32_t _size) -> ring_span<const uint8_t>;
+
+        void commit();
+
+    private:
+
+        auto consume(uint32_t _size) -> const uint8_t*;
+
+        mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>& buffer_;
+        TIMESTAMP_TYPE timestamp_;
+        uint32_t index_ = INVALID_INDEX;
+        uint32_t claimed_ = 0;
+        uint32_t size_ = 0;
+        uint32_t available_ = 0;
+    };
+
+    // == implementation of the buffer ========
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::~mpsc_transactional_ring_buffer() {
+        if (own_memory_) {
+            free_memory();
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::set_buffer(uint8_t* _memory, uint32_t _capacity) {
+        memory_ = _memory;
+        capacity_ = _capacity;
+        capacity_mask_ = capacity_ - 1;
+        start_ = 0;
+        if (memory_) {
+            memset(memory_, 0, capacity_);
+        }
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_release);
+        valid_ = memory_ != nullptr;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::reserve(uint32_t _wanted_capacity) -> bool {
+        if (!own_memory_ || _wanted_capacity > max_capacity()) {
+            return false;
+        }
+
+        auto new_capacity = min_capacity();
+        while (new_capacity < _wanted_capacity) {
+            new_capacity <<= 1;
+        }
+
+        if (valid_ && new_capacity <= capacity_) {
+            set_buffer(memory_, new_capacity);
+        } else {
+            free_memory();
+            set_buffer(new uint8_t[new_capacity], new_capacity);
+        }
+        return valid_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::borrow(uint8_t* _memory, uint32_t _capacity) -> bool {
+        if (!_memory || _capacity < min_capacity() || _capacity > max_capacity() || (_capacity & (_capacity - 1)) || ((uintptr_t)_memory % ALIGNMENT)) {
+            return false;
+        }
+        if (own_memory_) {
+            free_memory();
+            own_memory_ = false;
+        }
+        set_buffer(_memory, _capacity);
+        return valid_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::free_memory() {
+        delete[] memory_;
+        memory_ = nullptr;
+        valid_ = false;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::try_write(TIMESTAMP_TYPE _timestamp, uint32_t _max_size) -> mpsc_write_transaction<TIMESTAMP_TYPE> {
+        return mpsc_write_transaction<TIMESTAMP_TYPE>(*this, _timestamp, _max_size);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::try_read() -> mpsc_read_transaction<TIMESTAMP_TYPE> {
+        return mpsc_read_transaction<TIMESTAMP_TYPE>(*this);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::index_of(uint64_t _position) const -> uint32_t {
+        return (uint32_t)_position & capacity_mask_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::state(uint32_t _index) const -> std::atomic<uint32_t>& {
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "the state word is accessed in place");
+        return *reinterpret_cast<std::atomic<uint32_t>*>(&memory_[_index]);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::claim(uint32_t _size, uint32_t& _index) -> bool {
+        /*
+            Transactions never cross the end: the bytes up to the end are claimed (and published as padding) on
+            their own first, so that a drained buffer can always take the transaction at index 0
+        */
+        auto tail = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            auto idx = index_of(tail);
+            auto padding = idx + _size > capacity_ ? capacity_ - idx : 0;
+            auto bytes = padding ? padding : _size;
+            if (tail + bytes - head_.load(std::memory_order_acquire) > capacity_) {
+                return false;
+            }
+            if (tail_.compare_exchange_weak(tail, tail + bytes, std::memory_order_relaxed)) {
+                if (!padding) {
+                    _index = idx;
+                    return true;
+                }
+                publish(idx, COMMITTED | SKIP | padding);
+                tail += padding;
+            }
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::publish(uint32_t _index, uint32_t _state) {
+        state(_index).store(_state, std::memory_order_release);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::next_committed() -> uint32_t {
+        // skip padding and invalidated transactions; returns the state of the next one (0 if not committed)
+        auto skipped = false;
+        while (true) {
+            auto st = state(index_of(start_)).load(std::memory_order_acquire);
+            if ((st & (COMMITTED | SKIP)) != (COMMITTED | SKIP)) {
+                if (skipped) {
+                    head_.store(start_, std::memory_order_release);
+                }
+                return st;
+            }
+            release(st & SIZE_MASK);
+            skipped = true;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::release(uint32_t _size) {
+        memset(&memory_[index_of(start_)], 0, _size); // zeroed state words mean 'not committed' on the next lap
+        start_ += _size;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline constexpr auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::header_size() -> uint32_t {
+        return (uint32_t)(2 * sizeof(uint32_t) + sizeof(TIMESTAMP_TYPE)); // state, payload size and timestamp
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline constexpr auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::align(uint32_t _size) -> uint32_t {
+        return (_size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline constexpr auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::min_capacity() -> uint32_t {
+        return CACHE_LINE_SIZE > align(header_size()) ? CACHE_LINE_SIZE : 2 * CACHE_LINE_SIZE;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline constexpr auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::max_capacity() -> uint32_t {
+        return SIZE_MASK + 1;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::size() const -> uint32_t {
+        return (uint32_t)(tail_.load() - head_.load());
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::has_data() const -> bool {
+        return valid_ && (state(index_of(start_)).load(std::memory_order_acquire) & COMMITTED);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::capacity() const -> uint32_t {
+        return capacity_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>::operator bool() const {
+        return valid_;
+    }
+
+    // == implementation of write transactions ========
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline mpsc_write_transaction<TIMESTAMP_TYPE>::mpsc_write_transaction(mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer, TIMESTAMP_TYPE _timestamp, uint32_t _max_size) : buffer_(_buffer), timestamp_(_timestamp) {
+        if (_buffer && _max_size <= _buffer.capacity_ - _buffer.header_size()) {
+            claimed_ = _buffer.align(_buffer.header_size() + _max_size);
+            valid_ = claimed_ <= _buffer.capacity_ && _buffer.claim(claimed_, record_);
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline mpsc_write_transaction<TIMESTAMP_TYPE>::mpsc_write_transaction(mpsc_write_transaction&& _other) : buffer_(_other.buffer_), timestamp_(_other.timestamp_), record_(_other.record_), claimed_(_other.claimed_), size_(_other.size_), valid_(_other.valid_) {
+        _other.record_ = INVALID_INDEX;
+        _other.valid_ = false;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline mpsc_write_transaction<TIMESTAMP_TYPE>::~mpsc_write_transaction() {
+        commit();
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void mpsc_write_transaction<TIMESTAMP_TYPE>::invalidate() {
+        valid_ = false;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void mpsc_write_transaction<TIMESTAMP_TYPE>::commit() {
+        // note: the claimed room must always be published (as skipped if invalidated) or the consumer would stop here forever
+        if (record_ != INVALID_INDEX) {
+            if (valid_) {
+                memcpy(&buffer_.memory_[record_ + sizeof(uint32_t)], &size_, sizeof(size_));
+                memcpy(&buffer_.memory_[record_ + 2 * sizeof(uint32_t)], &timestamp_, sizeof(timestamp_));
+                buffer_.publish(record_, buffer_.COMMITTED | claimed_);
+            } else {
+                buffer_.publish(record_, buffer_.COMMITTED | buffer_.SKIP | claimed_);
+            }
+            record_ = INVALID_INDEX;
+            valid_ = false;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_write_transaction<TIMESTAMP_TYPE>::push_back(const uint8_t* _data, const uint32_t _size) -> bool {
+        if (!valid_ || size_ + _size > capacity()) {
+            return false;
+        }
+        memcpy(&buffer_.memory_[record_ + buffer_.header_size() + size_], _data, _size);
+        size_ += _size;
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename T>
+    forceinline auto mpsc_write_transaction<TIMESTAMP_TYPE>::push_back(const T& _data) -> bool {
+        return push_back(reinterpret_cast<const uint8_t*>(&_data), sizeof(T));
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename T, typename ...REST>
+    forceinline auto mpsc_write_transaction<TIMESTAMP_TYPE>::push_back(const T& _item, REST... _rest) -> typename std::enable_if<!std::is_pointer<T>::value, int>::type {
+        if (!push_back(_item)) {
+            return 0;
+        }
+        return 1 + push_back(_rest...);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline mpsc_write_transaction<TIMESTAMP_TYPE>::operator bool() const {
+        return valid_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_write_transaction<TIMESTAMP_TYPE>::size() const -> uint32_t {
+        return size_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_write_transaction<TIMESTAMP_TYPE>::capacity() const -> uint32_t {
+        return claimed_ - buffer_.header_size();
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_write_transaction<TIMESTAMP_TYPE>::timestamp() const -> TIMESTAMP_TYPE {
+        return timestamp_;
+    }
+
+    // == implementation of read transactions ========
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline mpsc_read_transaction<TIMESTAMP_TYPE>::mpsc_read_transaction(mpsc_transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer) : buffer_(_buffer) {
+        if (_buffer && !_buffer.reading_) {
+            if (auto st = _buffer.next_committed(); st & _buffer.COMMITTED) {
+                auto record = _buffer.index_of(_buffer.start_);
+                memcpy(&size_, &_buffer.memory_[record + sizeof(uint32_t)], sizeof(size_));
+                memcpy(&timestamp_, &_buffer.memory_[record + 2 * sizeof(uint32_t)], sizeof(timestamp_));
+                claimed_ = st & _buffer.SIZE_MASK;
+                available_ = size_;
+                index_ = record + _buffer.header_size();
+                _buffer.reading_ = true;
+            }
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline mpsc_read_transaction<TIMESTAMP_TYPE>::mpsc_read_transaction(mpsc_read_transaction&& _other) : buffer_(_other.buffer_), timestamp_(_other.timestamp_), index_(_other.index_), claimed_(_other.claimed_), size_(_other.size_), available_(_other.available_) {
+        _other.index_ = INVALID_INDEX; // note: not 'invalidate' as the buffer is still being read by this one
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline mpsc_read_transaction<TIMESTAMP_TYPE>::~mpsc_read_transaction() {
+        commit();
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void mpsc_read_transaction<TIMESTAMP_TYPE>::invalidate() {
+        if (*this) {
+            buffer_.reading_ = false;
+            index_ = INVALID_INDEX;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline void mpsc_read_transaction<TIMESTAMP_TYPE>::commit() {
+        if (*this) {
+            buffer_.release(claimed_);
+            buffer_.head_.store(buffer_.start_, std::memory_order_release);
+            buffer_.reading_ = false;
+            index_ = INVALID_INDEX;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_read_transaction<TIMESTAMP_TYPE>::consume(uint32_t _size) -> const uint8_t* {
+        if (!*this || _size > available_) {
+            return nullptr;
+        }
+        auto ret = &buffer_.memory_[index_];
+        index_ += _size;
+        available_ -= _size;
+        return ret;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename T>
+    forceinline auto mpsc_read_transaction<TIMESTAMP_TYPE>::pop_front() -> std::pair<T, bool> {
+        auto ret = std::pair<T, bool>{};
+        ret.second = pop_front(ret.first);
+        return ret;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename T>
+    forceinline auto mpsc_read_transaction<TIMESTAMP_TYPE>::pop_front(T& _dest) -> bool {
+        auto src = consume(sizeof(T));
+        if (!src) {
+            return false;
+        }
+        memcpy(&_dest, src, sizeof(T));
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename CALLBACK>
+    forceinline auto mpsc_read_transaction<TIMESTAMP_TYPE>::pop_front(uint32_t _size, CALLBACK&& _callback) -> typename std::enable_if<std::is_invocable<CALLBACK, const uint8_t*, uint32_t>::value, bool>::type {
+        auto src = consume(_size);
+        if (!src) {
+            return false;
+        }
+        _callback(src, _size);
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    template<typename T>
+    forceinline auto mpsc_read_transaction<TIMESTAMP_TYPE>::peek() -> const T* {
+        if (!*this || sizeof(T) > available_) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(&buffer_.memory_[index_]);
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_read_transaction<TIMESTAMP_TYPE>::view(uint32_t _size) -> ring_span<const uint8_t> {
+        auto first = consume(_size);
+        return { first, first ? _size : 0, nullptr, 0 };
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline mpsc_read_transaction<TIMESTAMP_TYPE>::operator bool() const {
+        return index_ != INVALID_INDEX;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_read_transaction<TIMESTAMP_TYPE>::size() const -> uint32_t {
+        return size_;
+    }
+
+    template<typename TIMESTAMP_TYPE>
+    forceinline auto mpsc_read_transaction<TIMESTAMP_TYPE>::timestamp() const -> TIMESTAMP_TYPE {
+        return timestamp_;
+    }
+
+} // namespace qcstudio
+} // namespace containers
+
+#pragma pop_macro("forceinline")
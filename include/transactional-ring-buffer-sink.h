@@ -0,0 +1,217 @@
+/*
+    MIT License
+
+    Copyright (c) 2016-2020 Raúl Ramos
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+/*
+    Disk sink (linux only)
+
+    A background thread that is the CONSUMER of several buffers and persists their transactions...
+
+        qcstudio::containers::disk_sink<time_type> sink;
+        sink.add(buffer_a, open("a.log", O_WRONLY | O_CREAT | O_APPEND, 0644));
+        sink.add(buffer_b, fd_b);
+        sink.start();
+        ...
+        sink.stop(); // writes what is left and joins the thread
+
+    FINALLY, notice that...
+
+        - every buffer is written with 'drain_to': one 'writev' per batch over the ring memory (at most two
+          segments), and its room is released only when the write has completed
+        - the files get the transactions as they are in the buffer: a header (size of the whole transaction,
+          payload included, and timestamp) followed by the payload
+        - the descriptors are not closed by the sink
+        - when a write fails the sink stops ('failed' returns true); what was not written in full is still in the
+          buffer (the file might end with part of a transaction)
+        - it does not work with buffers in overwrite mode
+        - 'SIZE_TYPE' must be the one of the buffers (see 'size_traits'): the headers go to the files as they are
+*/
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include "transactional-ring-buffer.h"
+
+#pragma push_macro("forceinline")
+#undef forceinline
+#if defined(_WIN32)
+#   define forceinline __forceinline
+#   pragma warning(disable : 4714)
+#elif defined (__clang__) || defined(__GNUC__)
+#   define forceinline __attribute__((always_inline))
+#else
+#   define forceinline inline
+#endif
+
+namespace qcstudio {
+namespace containers {
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE = uint32_t>
+    class disk_sink {
+
+    public:
+
+        /*
+            Construction / Destruction
+
+            - 'add' must be called before 'start'. It shall fail if the buffer is not valid or the descriptor is -1
+            - the destructor calls 'stop'
+        */
+        disk_sink() = default;
+        ~disk_sink();
+
+        auto add(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer, int _fd) -> bool;
+
+        /*
+            Thread control
+
+            - 'start' launches the thread. Each pass writes up to '_max_batch_bytes' of every buffer; when a pass
+              writes nothing the thread sleeps for '_idle'. It shall fail if already started or there are no buffers
+            - 'stop' writes everything committed before the call (not what producers keep committing) and joins
+              the thread
+            - 'written' is the total amount of bytes of whole transactions written (those consumed from the buffers);
+              'failed' tells if a write failed (the sink stopped)
+        */
+        auto start(uint64_t _max_batch_bytes = 1 << 20, std::chrono::nanoseconds _idle = std::chrono::microseconds(100)) -> bool;
+        void stop();
+        auto written() const -> uint64_t;
+        auto failed() const -> bool;
+
+    private:
+
+        struct source {
+            transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>* buffer;
+            int fd;
+        };
+
+        std::vector<source> sources_;
+        std::thread thread_;
+        std::atomic<bool> running_ = ATOMIC_VAR_INIT(false);
+        std::atomic<bool> failed_ = ATOMIC_VAR_INIT(false);
+        std::atomic<uint64_t> written_ = ATOMIC_VAR_INIT(0);
+
+        // Disallow copy and assign
+
+        disk_sink(const disk_sink&) = delete;
+        auto operator =(const disk_sink&) -> disk_sink& = delete;
+
+        // helpers
+
+        void run(uint64_t _max_batch_bytes, std::chrono::nanoseconds _idle);
+        auto pass(uint64_t _max_batch_bytes) -> uint64_t;                 // bytes written (stops on failure)
+        auto drain(source& _source, uint64_t _max_bytes) -> uint64_t;     // bytes written (0 on failure)
+    };
+
+    // == implementation ========
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline disk_sink<TIMESTAMP_TYPE, SIZE_TYPE>::~disk_sink() {
+        stop();
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto disk_sink<TIMESTAMP_TYPE, SIZE_TYPE>::add(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer, int _fd) -> bool {
+        if (!_buffer || _fd == -1 || thread_.joinable()) {
+            return false;
+        }
+        sources_.push_back({ &_buffer, _fd });
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto disk_sink<TIMESTAMP_TYPE, SIZE_TYPE>::start(uint64_t _max_batch_bytes, std::chrono::nanoseconds _idle) -> bool {
+        if (thread_.joinable() || sources_.empty()) {
+            return false;
+        }
+        running_.store(true, std::memory_order_relaxed);
+        thread_ = std::thread([this, _max_batch_bytes, _idle]() { run(_max_batch_bytes, _idle); });
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void disk_sink<TIMESTAMP_TYPE, SIZE_TYPE>::stop() {
+        if (thread_.joinable()) {
+            running_.store(false, std::memory_order_release);
+            thread_.join();
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto disk_sink<TIMESTAMP_TYPE, SIZE_TYPE>::written() const -> uint64_t {
+        return written_.load(std::memory_order_relaxed);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto disk_sink<TIMESTAMP_TYPE, SIZE_TYPE>::failed() const -> bool {
+        return failed_.load(std::memory_order_relaxed);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void disk_sink<TIMESTAMP_TYPE, SIZE_TYPE>::run(uint64_t _max_batch_bytes, std::chrono::nanoseconds _idle) {
+        while (running_.load(std::memory_order_acquire) && !failed()) {
+            if (!pass(_max_batch_bytes)) {
+                std::this_thread::sleep_for(_idle);
+            }
+        }
+
+        // leftovers: only what was committed before 'stop' (busy producers would keep the thread here forever)
+        for (auto& source : sources_) {
+            for (auto left = (uint64_t)source.buffer->size(); left && !failed();) {
+                auto bytes = drain(source, left);
+                if (bytes == 0) {
+                    break;
+                }
+                left -= std::min(bytes, left); // note: 'left' includes padding, which is not written
+            }
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto disk_sink<TIMESTAMP_TYPE, SIZE_TYPE>::pass(uint64_t _max_batch_bytes) -> uint64_t {
+        auto ret = uint64_t(0);
+        for (auto& source : sources_) {
+            ret += drain(source, _max_batch_bytes);
+            if (failed()) {
+                return 0;
+            }
+        }
+        return ret;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto disk_sink<TIMESTAMP_TYPE, SIZE_TYPE>::drain(source& _source, uint64_t _max_bytes) -> uint64_t {
+        // 'written_' is updated per buffer: what was written before a failure is still accounted
+        auto bytes = _source.buffer->drain_to(_source.fd, _max_bytes);
+        if (bytes < 0) {
+            failed_.store(true, std::memory_order_relaxed);
+            return 0;
+        }
+        written_.fetch_add((uint64_t)bytes, std::memory_order_relaxed);
+        return (uint64_t)bytes;
+    }
+
+} // namespace qcstudio
+} // namespace containers
+
+#pragma pop_macro("forceinline")
@@ -0,0 +1,246 @@
+/*
+    MIT License
+
+    Copyright (c) 2016-2020 Raúl Ramos
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+/*
+    Spilling buffer (linux only)
+
+    A buffer that neither drops data nor blocks the producer when it is full: the overflow goes to a file...
+
+        qcstudio::containers::spilling_transactional_ring_buffer<time_type> buffer;
+        buffer.reserve(8192, "/var/tmp/audit.spill");
+
+        if (auto wr = buffer.try_write(now, sizeof(int))) { // same transactions as the plain buffer
+            wr.push_back(42);
+        }
+        ...
+        if (auto rd = buffer.try_read()) {
+            ...
+        }
+
+    FINALLY, notice that...
+
+        - while nothing is spilled, transactions go straight to the in-memory buffer (one flag check)
+        - once the memory is full, the producer writes to a staging buffer that a background thread (a
+          'disk_sink') appends to the spill file. It keeps spilling until the consumer has taken back everything
+          spilled, so the write order is kept
+        - the consumer reads the memory first (older), then the spilled transactions (loaded back into a replay
+          buffer with 'read_from') and then the memory again
+        - 'try_write' fails only when the staging buffer is full too. Transactions cannot be bigger than it
+        - 'try_read' can fail while spilled transactions are still on their way to the file
+        - the spill file is truncated by 'reserve' and never shrinks while the buffer is alive
+        - 'SIZE_TYPE' (see 'size_traits') applies to the three inner buffers and to the headers in the spill file
+*/
+
+#pragma once
+
+#include "transactional-ring-buffer-sink.h"
+
+#pragma push_macro("forceinline")
+#undef forceinline
+#if defined(_WIN32)
+#   define forceinline __forceinline
+#   pragma warning(disable : 4714)
+#elif defined (__clang__) || defined(__GNUC__)
+#   define forceinline __attribute__((always_inline))
+#else
+#   define forceinline inline
+#endif
+
+namespace qcstudio {
+namespace containers {
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    class spilling_transactional_ring_buffer {
+
+    public:
+
+        /*
+            Construction / Destruction
+
+            - 'reserve' allocates the in-memory buffer (same rules as 'transactional_ring_buffer::reserve'), the
+              staging and replay buffers ('_staging_capacity' each), creates / truncates '_spill_path' and starts
+              the writer thread. It must be called once, before any transaction
+            - the destructor stops the writer thread and closes the file (it is not removed)
+        */
+        spilling_transactional_ring_buffer() = default;
+        ~spilling_transactional_ring_buffer();
+
+        auto reserve(SIZE_TYPE _wanted_capacity, const char* _spill_path, SIZE_TYPE _staging_capacity = 1 << 20, memory_layout _layout = memory_layout::ring) -> bool;
+
+        /*
+            Getters
+
+            - 'spilled' is the amount of bytes written to the spill file (headers included)
+        */
+        explicit operator bool() const;
+        auto capacity() const -> SIZE_TYPE;
+        auto spilled() const -> uint64_t;
+
+        /*
+            Transactions (see 'transactional_ring_buffer')
+        */
+        auto try_write(TIMESTAMP_TYPE _timestamp, SIZE_TYPE _min_size = 0) -> write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+        auto try_read() -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+
+    private:
+
+        auto load() -> bool; // consumer only: moves spilled transactions into 'replay_'
+
+        transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE> memory_;
+        transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE> staging_; // producer => writer thread
+        transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE> replay_;  // consumer only
+        disk_sink<TIMESTAMP_TYPE, SIZE_TYPE> writer_;
+        int write_fd_ = -1, read_fd_ = -1;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> loaded_ = ATOMIC_VAR_INIT(0); // bytes of the file loaded back
+
+        alignas(CACHE_LINE_SIZE) bool spilling_ = false;  // producer
+        alignas(CACHE_LINE_SIZE) bool replaying_ = false; // consumer
+
+        // Disallow copy and assign
+
+        spilling_transactional_ring_buffer(const spilling_transactional_ring_buffer&) = delete;
+        auto operator =(const spilling_transactional_ring_buffer&) -> spilling_transactional_ring_buffer& = delete;
+    };
+
+    // == implementation ========
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline spilling_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::~spilling_transactional_ring_buffer() {
+        writer_.stop();
+        for (auto fd : { write_fd_, read_fd_ }) {
+            if (fd != -1) {
+                close(fd);
+            }
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto spilling_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::reserve(SIZE_TYPE _wanted_capacity, const char* _spill_path, SIZE_TYPE _staging_capacity, memory_layout _layout) -> bool {
+#if defined(__linux__)
+        if (write_fd_ != -1 || !memory_.reserve(_wanted_capacity, _layout) || !staging_.reserve(_staging_capacity) || !replay_.reserve(staging_.capacity())) {
+            return false;
+        }
+        write_fd_ = open(_spill_path, O_CREAT | O_TRUNC | O_WRONLY | O_APPEND | O_CLOEXEC, 0600);
+        read_fd_ = write_fd_ == -1 ? -1 : open(_spill_path, O_RDONLY | O_CLOEXEC);
+        return read_fd_ != -1 && writer_.add(staging_, write_fd_) && writer_.start();
+#else
+        (void)_wanted_capacity; (void)_spill_path; (void)_staging_capacity; (void)_layout;
+        return false;
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline spilling_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::operator bool() const {
+        return read_fd_ != -1 && (bool)memory_;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto spilling_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::capacity() const -> SIZE_TYPE {
+        return memory_.capacity();
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto spilling_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::spilled() const -> uint64_t {
+        return writer_.written();
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto spilling_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::try_write(TIMESTAMP_TYPE _timestamp, SIZE_TYPE _min_size) -> write_transaction<TIMESTAMP_TYPE, SIZE_TYPE> {
+        if (spilling_ && !staging_.writing_ && staging_.end_ == loaded_.load(std::memory_order_acquire)) {
+            // note: staged transactions are whole records in the file ('ring' layout: no padding)
+            spilling_ = false; // the consumer has taken back everything: newer transactions can go to memory
+        }
+        if (!spilling_) {
+            auto wr = memory_.try_write(_timestamp, _min_size);
+            if (wr || memory_.writing_ || !*this) {
+                return wr;
+            }
+            spilling_ = true;
+        }
+        return staging_.try_write(_timestamp, _min_size);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto spilling_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::try_read() -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE> {
+        if (replaying_) {
+            auto rd = replay_.try_read();
+            if (rd || replay_.reading_) {
+                return rd;
+            }
+            replaying_ = false;
+        }
+        auto rd = memory_.try_read();
+        if (rd || memory_.reading_ || !load()) {
+            return rd;
+        }
+        replaying_ = true;
+        return replay_.try_read();
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    auto spilling_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::load() -> bool {
+#if defined(__linux__)
+        // whole records already in the file, as many as fit in the replay buffer
+        const auto header_size = transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>::header_size();
+        const auto available = writer_.written();
+        auto offset = loaded_.load(std::memory_order_relaxed);
+        auto ret = false;
+        while (offset < available) {
+            SIZE_TYPE size;
+            TIMESTAMP_TYPE timestamp;
+            if (pread(read_fd_, &size, sizeof(size), (off_t)offset) != sizeof(size) ||
+                size < header_size ||
+                pread(read_fd_, &timestamp, sizeof(timestamp), (off_t)(offset + sizeof(size))) != sizeof(timestamp) ||
+                lseek(read_fd_, (off_t)(offset + header_size), SEEK_SET) == -1) {
+                break;
+            }
+            {
+                auto wr = replay_.try_write(timestamp, size - header_size);
+                if (!wr) {
+                    break; // replay buffer full
+                }
+                for (auto left = size - header_size; left;) {
+                    auto bytes = wr.read_from(read_fd_, left);
+                    if (bytes <= 0) {
+                        wr.invalidate();
+                        return ret;
+                    }
+                    left -= (SIZE_TYPE)bytes;
+                }
+            }
+            offset += size;
+            loaded_.store(offset, std::memory_order_release);
+            ret = true;
+        }
+        return ret;
+#else
+        return false;
+#endif
+    }
+
+} // namespace qcstudio
+} // namespace containers
+
+#pragma pop_macro("forceinline")
@@ -63,12 +63,32 @@
 
 */
 
+#pragma once
+
 #include <atomic>
 #include <type_traits>
 #include <utility>
 #include <algorithm>
 #include <functional>
 #include <cstring>
+#include <chrono>
+#include <thread>
+#include <climits>
+#include <new>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/futex.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
 
 #pragma push_macro("forceinline")
 #undef forceinline
@@ -84,11 +104,190 @@
 namespace qcstudio {
 namespace containers {
 
-    template<typename TIMESTAMP_TYPE> class transaction_base;
-    template<typename TIMESTAMP_TYPE> class read_transaction;
-    template<typename TIMESTAMP_TYPE> class write_transaction;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE = uint32_t> class transaction_base;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE = uint32_t> class read_transaction;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE = uint32_t> class write_transaction;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE = uint32_t> class read_batch;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE = uint32_t> class elastic_transactional_ring_buffer;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE = uint32_t> class spilling_transactional_ring_buffer;
+
+    // note: std::hardware_destructive_interference_size is not ABI-stable (gcc warns when used in headers)
+    static constexpr uint32_t CACHE_LINE_SIZE = 64;
+
+    /*
+        Size types
+
+        The second template parameter of the buffer (and its transactions) is the type of capacities, indices
+        and transaction sizes:
+
+        - 'uint32_t' (default): capacities up to 2 GiB (1 GiB 'mirrored') and the smallest headers
+        - 'uint64_t': bigger capacities, at the cost of 4 more bytes on every transaction header
+
+        Positions ('end_', 'tail', ...) are always 64-bit. The elastic and spilling buffers and the disk sink take the
+        same parameter; the multiple producers and broadcast buffers and the merge helper use 'uint32_t'.
+    */
+    template<typename SIZE_TYPE>
+    struct size_traits {
+        static_assert(std::is_same<SIZE_TYPE, uint32_t>::value || std::is_same<SIZE_TYPE, uint64_t>::value, "SIZE_TYPE must be uint32_t or uint64_t");
+
+        static constexpr SIZE_TYPE INVALID_INDEX = ~SIZE_TYPE(0);
+        static constexpr SIZE_TYPE PADDING_FLAG  = SIZE_TYPE(1) << (sizeof(SIZE_TYPE) * CHAR_BIT - 1); // on 'transaction_header::size', the rest is the amount of bytes to skip
+    };
+
+    /*
+        Memory layouts
+
+        - 'ring':     plain ring buffer. Data crossing the end of the buffer is split in two chunks
+        - 'mirrored': (linux only) the same physical pages are mapped twice, back to back, so that
+                      any transaction is contiguous in virtual memory. Capacity is at least 1 page
+        - 'padded':   transactions never cross the end of the buffer; when one would, the bytes up to the
+                      end are skipped (padding) and the transaction is (re)placed at the beginning. It works
+                      with borrowed memory at the cost of some wasted bytes per lap (see 'padding_size').
+                      The padding is published on its own, so any transaction up to the capacity fits once
+                      the consumer has drained the buffer. A transaction that grows across the end can only
+                      be moved while it holds fewer bytes than there are before it (size it with '_min_size')
+    */
+    enum class memory_layout {
+        ring,
+        mirrored,
+        padded
+    };
+
+    // Transactions / bytes discarded by 'expire_before' (bytes include any padding)
+    struct expiry_stats {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    /*
+        Control block
+
+        The state published by each side, every group on its own cache line. It is a member of the buffer
+        unless the buffer is shared between processes ('create_shared' / 'attach_shared'): then it lives at the
+        head of the mapping, followed by the data, and its first line describes that data.
+    */
+    struct control_block {
+        static constexpr uint32_t MAGIC   = 0x51435452; // "QCTR"
+        static constexpr uint32_t VERSION = 2;          // bump on any change of this struct
+
+        // description (shared buffers only); 'magic' is written last by the creator
+        alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> magic = ATOMIC_VAR_INIT(0);
+        uint32_t version = 0;
+        uint64_t capacity = 0;
+        uint32_t layout = 0;
+        uint32_t timestamp_size = 0;
+        uint32_t size_type_size = 0;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail = ATOMIC_VAR_INIT(0);
+        std::atomic<uint32_t> consumer_waiters = ATOMIC_VAR_INIT(0); // parked on 'tail'
+        std::atomic<bool> data_armed = ATOMIC_VAR_INIT(false);       // the consumer saw it empty
+        std::atomic<uint64_t> index_count = ATOMIC_VAR_INIT(0);      // number of index entries recorded
+        std::atomic<uint64_t> oldest = ATOMIC_VAR_INIT(0);           // overwrite mode: first position not dropped
+        std::atomic<uint64_t> lost = ATOMIC_VAR_INIT(0);
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head = ATOMIC_VAR_INIT(0);
+        std::atomic<uint32_t> producer_waiters = ATOMIC_VAR_INIT(0); // parked on 'head'
+        std::atomic<bool> room_armed = ATOMIC_VAR_INIT(false);       // the producer saw it full
+    };
+
+    // == Wait strategies ========
+
+    /*
+        Wait strategies for the blocking 'write' / 'read'
+
+        - 'wait' is called every time the operation could not be done. It can return spuriously
+          '_position' is the position published by the other side and '_seen' its last observed value
+          '_waiters' is the parking counter of that position (nullptr if the buffer does not allow parking)
+        - 'busy_spin':      retry immediately
+        - 'spin_pause':     retry after a cpu pause instruction
+        - 'yield':          retry after yielding the thread
+        - 'spin_then_park': spin for a while and then park the thread until the other side publishes
+                            (futex on linux, yield elsewhere or when parking is not allowed)
+    */
+    namespace wait_strategy {
+
+        using time_point = std::chrono::steady_clock::time_point;
+
+        inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+            _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+            __asm__ __volatile__("yield");
+#else
+            std::this_thread::yield();
+#endif
+        }
+
+#if defined(__linux__)
+        // futexes are 32-bit; the low half of the position changes on every publication
+        inline auto futex_word(std::atomic<uint64_t>& _position) -> uint32_t* {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            return reinterpret_cast<uint32_t*>(&_position) + 1;
+#else
+            return reinterpret_cast<uint32_t*>(&_position);
+#endif
+        }
+#endif
+
+        // parking / unparking on a position (the waker side only pays when there are waiters)
+        // note: 'unpark' callers must issue a seq_cst fence between the publication and the call
+        // note: the futexes are not private so that processes sharing a buffer can park on it
+        inline void park(std::atomic<uint64_t>& _position, uint64_t _seen, std::atomic<uint32_t>& _waiters, time_point _deadline) {
+#if defined(__linux__)
+            auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(_deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                return;
+            }
+            _waiters.fetch_add(1, std::memory_order_seq_cst);
+            if (_position.load(std::memory_order_seq_cst) == _seen) {
+                timespec timeout = { (time_t)(remaining / 1000000000), (long)(remaining % 1000000000) };
+                syscall(SYS_futex, futex_word(_position), FUTEX_WAIT, (uint32_t)_seen, &timeout, nullptr, 0);
+            }
+            _waiters.fetch_sub(1, std::memory_order_release);
+#else
+            (void)_position; (void)_seen; (void)_waiters; (void)_deadline;
+            std::this_thread::yield();
+#endif
+        }
+
+        inline void unpark(std::atomic<uint64_t>& _position, std::atomic<uint32_t>& _waiters) {
+            if (_waiters.load(std::memory_order_relaxed)) {
+#if defined(__linux__)
+                syscall(SYS_futex, futex_word(_position), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+            }
+        }
+
+        struct busy_spin {
+            void wait(std::atomic<uint64_t>&, uint64_t, std::atomic<uint32_t>*, time_point) {}
+        };
+
+        struct spin_pause {
+            void wait(std::atomic<uint64_t>&, uint64_t, std::atomic<uint32_t>*, time_point) { cpu_relax(); }
+        };
+
+        struct yield {
+            void wait(std::atomic<uint64_t>&, uint64_t, std::atomic<uint32_t>*, time_point) { std::this_thread::yield(); }
+        };
+
+        struct spin_then_park {
+            static constexpr uint32_t SPINS = 1024;
+            uint32_t spins = 0;
+
+            void wait(std::atomic<uint64_t>& _position, uint64_t _seen, std::atomic<uint32_t>* _waiters, time_point _deadline) {
+                if (spins < SPINS) {
+                    ++spins;
+                    cpu_relax();
+                } else if (_waiters) {
+                    park(_position, _seen, *_waiters, _deadline);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        };
+    } // namespace wait_strategy
 
-    template<typename TIMESTAMP_TYPE>
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE = uint32_t>
     class transactional_ring_buffer {
 
     public:
@@ -103,29 +302,76 @@ namespace containers {
             - 'reserve' and 'borrow' are mutually exclusive and must be called before any transaction
             - 'reserve', regardless of _wanted_capacity, shall use a capacity greater or equal that is power of 2 
             - 'reserve' called many times frees the previous buffer and allocate a new one
+            - 'reserve' shall fail if the memory layout is not supported on the platform
+            - 'reserve' shall fail if _wanted_capacity is above 'max_capacity' for the layout
 
             - 'borrow' shall fail if the size is not power of 2 or below 'min_capacity'
+            - 'borrow' shall fail with 'memory_layout::mirrored' (it requires control over the mapping)
             - 'borrow' called many times substitutes previous buffer
             - The memory ownership of 'borrow' parameter is external
         */
         transactional_ring_buffer() = default;
         ~transactional_ring_buffer();
 
-        auto reserve(uint32_t _wanted_capacity) -> bool;
-        auto borrow(uint8_t* _memory, uint32_t _capacity) -> bool;
+        auto reserve(SIZE_TYPE _wanted_capacity, memory_layout _layout = memory_layout::ring) -> bool;
+        auto borrow(uint8_t* _memory, SIZE_TYPE _capacity, memory_layout _layout = memory_layout::ring) -> bool;
+
+        /*
+            Shared memory (linux only)
+
+            - 'create_shared' creates the POSIX shared memory object '_name' (e.g. "/my-buffer") holding the control
+              block followed by the data, and maps it. It fails if the object already exists, with the 'mirrored'
+              layout, after 'borrow' or if doorbells or the index are enabled
+            - 'attach_shared' maps an existing object. It fails unless it was created by 'create_shared' with the
+              same control block version and timestamp size. The endpoint resumes from the published positions
+            - the producer and the consumer processes each use an endpoint (a buffer object): one creates the
+              object and the other attaches to it. A restarted side attaches again
+            - options are per endpoint: both must enable parking or overwrite. Doorbells and the sparse index are
+              process-local and fail on shared buffers
+            - the mapping is released by the destructor or 'reserve'; 'unlink_shared' removes the name
+        */
+        auto create_shared(const char* _name, SIZE_TYPE _wanted_capacity, memory_layout _layout = memory_layout::ring) -> bool;
+        auto attach_shared(const char* _name) -> bool;
+        static auto unlink_shared(const char* _name) -> bool;
+
+        /*
+            Persistence (linux only)
+
+            - 'open_file' maps the file '_path' (created with '_wanted_capacity' / '_layout' if it is missing or empty)
+              holding the control block followed by the data, as 'create_shared' does. Transactions survive a
+              restart of the process, and of the machine once synced
+            - an existing file is recovered: its description must match (capacity and layout are taken from it)
+              and its positions must be consistent; committed records are walked from the consumed position and
+              the tail is moved back to the first one with an inconsistent header. Records that were not
+              committed never reached the tail. Consumption resumes from the last published read position
+            - 'set_sync_policy' makes the producer 'msync' the mapping (data and control block) every '_every_bytes'
+              bytes published or every '_every' (checked on publications). 'sync' does it on demand
+            - without syncs the data survives crashes of the processes (page cache) but not of the machine
+        */
+        auto open_file(const char* _path, SIZE_TYPE _wanted_capacity, memory_layout _layout = memory_layout::ring) -> bool;
+        void set_sync_policy(uint64_t _every_bytes, std::chrono::nanoseconds _every = std::chrono::nanoseconds::zero());
+        auto sync() -> bool;
 
         /*
             Getters
 
             - 'min_capacity' shall return a value power of 2
-            - 'has_data' must be called from the consumer only
+            - 'max_capacity' is the biggest power of 2 the size type can hold (half of it 'mirrored', as the
+              pages are mapped twice)
+            - 'has_data' must be called from the consumer only. On 'padded' buffers the data might be padding only
             - 'size' is a debug function (use always 'try_read' / 'try_write').
+            - 'padding_size' is the total amount of bytes skipped by the 'padded' layout (producer only)
+            - 'next_timestamp' reads the timestamp of the next transaction without consuming it (consumer only).
+              It shall fail if there is no data or a read transaction is in progress
         */
-        static constexpr auto min_capacity() -> uint32_t;
+        static constexpr auto min_capacity() -> SIZE_TYPE;
+        static constexpr auto max_capacity(memory_layout _layout = memory_layout::ring) -> SIZE_TYPE;
         auto has_data() const -> bool;
-        auto size() const -> uint32_t;
+        auto size() const -> SIZE_TYPE;
         explicit operator bool() const;
-        auto capacity() const -> uint32_t;
+        auto capacity() const -> SIZE_TYPE;
+        auto padding_size() const -> uint64_t;
+        auto next_timestamp(TIMESTAMP_TYPE& _timestamp) -> bool;
 
         /*
             Transactions
@@ -134,21 +380,193 @@ namespace containers {
             - There can only be 1 transaction per type per buffer at a time. Subsequent attempts to
               create the same type of transactions shall fail until commit or invalidate.
             - Transactions might fail if there is no room to write or there is no data to read
+            - 'try_write' shall fail unless there is room for at least '_min_size' bytes of payload
             - Write transactions shall be created by producer and read transactions
               shall be created by the consumer
         */
-        auto try_write(TIMESTAMP_TYPE _timestamp) -> write_transaction<TIMESTAMP_TYPE>;
-        auto try_read()                           -> read_transaction<TIMESTAMP_TYPE>;
+        auto try_write(TIMESTAMP_TYPE _timestamp, SIZE_TYPE _min_size = 0) -> write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+        auto try_read()                                                    -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+
+        /*
+            Blocking transactions
+
+            - same as 'try_write' / 'try_read' but waiting up to '_timeout' for room / data with the given wait strategy
+            - '_min_size' is the amount of payload bytes that must fit in the write transaction
+            - they fail immediately if a transaction of the same type is already in progress
+            - 'enable_parking' must be called (before any transaction) for parking strategies to park; otherwise they
+              yield. Once enabled, every publication checks (with a fence) whether the other side is parked
+        */
+        template<typename WAIT_STRATEGY = wait_strategy::spin_then_park>
+        auto write(TIMESTAMP_TYPE _timestamp, std::chrono::nanoseconds _timeout, SIZE_TYPE _min_size = 0) -> write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+
+        template<typename WAIT_STRATEGY = wait_strategy::spin_then_park>
+        auto read(std::chrono::nanoseconds _timeout) -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+
+        void enable_parking(bool _enable = true);
+
+        /*
+            Overwrite mode (flight recorder)
+
+            - 'enable_overwrite' must be called before any transaction. The producer never runs out of room: when
+              the buffer is full it drops the oldest transactions, whether they have been read or not. It only walks
+              the headers it drops (bounded by the capacity), so writes stay wait-free
+            - the consumer jumps over dropped transactions. A transaction can still be overwritten while it is being
+              read; data obtained from it is only reliable if 'clobbered' returns false after reading it
+            - 'lost' is the number of transactions dropped before the consumer published them as consumed
+              (approximate with 'drain', as batches publish late)
+        */
+        void enable_overwrite(bool _enable = true);
+        auto lost() const -> uint64_t;
+
+        /*
+            Doorbells (linux only)
+
+            - 'enable_doorbells' creates two non-blocking eventfds meant to be registered in an epoll / poll loop.
+              It must be called before any transaction and fails on other platforms or if eventfd fails
+            - 'data_eventfd' becomes readable when a publication takes the buffer from empty to non-empty after
+              the consumer has seen it empty (a failed 'try_read' / 'drain')
+            - 'room_eventfd' becomes readable when the consumer frees room after the producer has seen the buffer
+              full (a failed 'try_write')
+            - signals are coalesced: there is at most one eventfd write per edge, not per transaction. Hence,
+              consumers must read the eventfd and then read transactions until 'try_read' fails (which re-arms it)
+            - both return -1 when doorbells are not enabled. The descriptors are closed by the destructor
+        */
+        auto enable_doorbells() -> bool;
+        auto data_eventfd() const -> int;
+        auto room_eventfd() const -> int;
+
+        /*
+            Batched reads
+
+            - 'drain' takes a single snapshot of the committed data and iterates over the read transactions
+              in it (range-for) up to '_max_count' transactions or '_max_bytes' (the transaction that reaches
+              the limit is included)
+            - the consumed position is published once, when the batch is destroyed (or on 'commit')
+            - an invalidated transaction ends the batch and stays in the buffer
+            - while the batch is alive 'try_read' shall fail
+            - 'drain_to' (linux only) writes the committed transactions as they are (headers included, padding left
+              out) to '_fd' with a single 'writev' over the ring memory (no copies), up to '_max_bytes' (the
+              transaction that reaches the limit is included). The consumed position is published only once
+              everything is written. It returns the bytes written, 0 if there is no data or -1 on error (or while
+              reading, or in overwrite mode). On an error after some writes, the transactions written in full are
+              consumed and their bytes returned (the error shows up on the next call); the rest stays in the
+              buffer, and the file might end with part of the first of them (written again in full on retry)
+        */
+        auto drain(uint32_t _max_count = 0xFFffFFff, uint64_t _max_bytes = ~0ull) -> read_batch<TIMESTAMP_TYPE, SIZE_TYPE>;
+        auto drain_to(int _fd, uint64_t _max_bytes = ~0ull) -> int64_t;
+
+        /*
+            Sparse timestamp index
+
+            - 'enable_index' makes the producer record the position and timestamp of one transaction every
+              '_every_transactions' transactions or every '_every_bytes' bytes into a side array of '_entries'
+              entries (rounded up to a power of 2). It must be called before any transaction
+            - an entry is not recorded (it is postponed to the next transaction) while its slot still indexes
+              data that has not been consumed, so the index never slows the producer down
+            - 'seek' (consumer only) discards every transaction older than '_timestamp' with a single publication:
+              it binary-searches the index and then walks at most the headers between two entries. It returns
+              true if the next transaction is not older than '_timestamp'. It works with and without index
+              (without it, it walks all the headers) and fails if a read transaction is in progress
+            - in overwrite mode 'seek' starts from the oldest transaction kept. It fails without moving if the
+              producer overwrites the headers it walks
+            - timestamps are expected to be nondecreasing
+        */
+        auto enable_index(uint32_t _entries, uint32_t _every_transactions, uint32_t _every_bytes = 0xFFffFFff) -> bool;
+        auto seek(TIMESTAMP_TYPE _timestamp) -> bool;
+
+        /*
+            Expiry (consumer only)
+
+            - 'expire_before' discards all the transactions older than '_cutoff' walking only their headers and
+              publishes the new position once. It fails (returns zeros) if a read transaction is in progress
+            - 'set_expiry_policy' makes 'try_read' and 'drain' call 'expire_before' with the value returned by
+              '_cutoff' (e.g. now - max age) before reading. An empty function disables it
+            - 'expired' is the total discarded by the policy
+        */
+        auto expire_before(TIMESTAMP_TYPE _cutoff) -> expiry_stats;
+        void set_expiry_policy(std::function<TIMESTAMP_TYPE()> _cutoff);
+        auto expired() const -> expiry_stats;
+
+        /*
+            Group commit (producer only)
+
+            - by default every committed write transaction is immediately visible to the consumer
+            - 'set_publish_policy' defers the publication until '_max_transactions' transactions or '_max_bytes'
+              bytes are committed, or the oldest pending one is '_max_delay' old (zero means no deadline).
+              The deadline is checked on 'try_write' and on commits, so idle producers must call 'flush'
+            - 'flush' publishes all the committed transactions. It also happens when the buffer looks full
+            - transactions are still all or nothing; only their visibility is delayed
+        */
+        void set_publish_policy(uint32_t _max_transactions, uint32_t _max_bytes = 0xFFffFFff, std::chrono::nanoseconds _max_delay = std::chrono::nanoseconds::zero());
+        void flush();
 
     private:
+
+        /*
+            Data layout
+
+            Every group lives on its own cache line so that the producer and the consumer never
+            invalidate each other's private state:
+
+            - configuration: only written by 'reserve' / 'borrow' (read-only while transacting)
+            - tail / head:   published positions (written by its owner, read by the other side). They are
+                             in the control block, see 'control_block'
+            - producer:      touched by write transactions only
+            - consumer:      touched by read transactions only
+
+            Positions are monotonically increasing 64-bit byte counters (the ring index is 'index_of(position)')
+            so 'tail - head' is always the amount of committed data. Each side keeps a cached copy of the
+            other side's position and only reloads it when the cached value says there is no room / no data.
+        */
+
+        alignas(CACHE_LINE_SIZE) uint8_t* memory_ = nullptr;
+        SIZE_TYPE capacity_ = 0, capacity_mask_ = 0;
+        SIZE_TYPE linear_size_ = 0; // bytes addressable from 'memory_' without wrapping (2 * capacity_ when mirrored)
+        memory_layout layout_ = memory_layout::ring;
         bool valid_ = false;
         bool own_memory_ = true;
-        bool reading_ = false, writing_ = false;
-
-        uint32_t capacity_ = 0, capacity_mask_;
-        uint32_t start_, end_;
-        std::atomic_uint32_t size_ = ATOMIC_VAR_INIT(0);
-        uint8_t* memory_ = nullptr;
+        bool parking_ = false;
+        bool notify_ = false; // 'parking_' or doorbells enabled
+        bool overwrite_ = false;
+        bool sync_ = false;
+        int data_fd_ = -1, room_fd_ = -1;
+
+        struct index_entry {
+            std::atomic<uint64_t> position; // written last (release); the timestamp is valid while it is not consumed
+            TIMESTAMP_TYPE timestamp;
+        };
+        index_entry* index_ = nullptr;
+        uint32_t index_mask_ = 0;
+        uint32_t index_every_count_ = 0, index_every_bytes_ = 0;
+        control_block* control_ = &local_control_; // or the head of the mapping of a shared buffer
+        uint8_t* mapping_ = nullptr;               // shared buffers only
+        size_t mapping_size_ = 0;
+        uint64_t sync_every_bytes_ = ~0ull;
+        std::chrono::nanoseconds sync_every_ = std::chrono::nanoseconds::zero();
+
+        control_block local_control_; // tail / head lines of a buffer private to the process
+
+        alignas(CACHE_LINE_SIZE) uint64_t end_ = 0; // producer copy of 'tail' (ahead of it while there are pending transactions)
+        uint64_t head_cache_ = 0;
+        uint64_t padding_size_ = 0;
+        bool writing_ = false;
+        uint32_t pending_count_ = 0;
+        uint64_t pending_bytes_ = 0;
+        uint32_t publish_count_ = 1, publish_bytes_ = 0xFFffFFff;
+        std::chrono::nanoseconds publish_delay_ = std::chrono::nanoseconds::zero();
+        std::chrono::steady_clock::time_point pending_since_;
+        uint64_t index_end_ = 0; // producer copy of 'index_count'
+        uint32_t index_since_count_ = 0;
+        uint64_t index_since_bytes_ = 0;
+        uint64_t synced_end_ = 0; // published position at the last sync
+        std::chrono::steady_clock::time_point synced_at_;
+
+        alignas(CACHE_LINE_SIZE) uint64_t start_ = 0; // consumer copy of 'head'
+        uint64_t tail_cache_ = 0;
+        uint64_t index_start_ = 0; // first index entry that might point to unconsumed data
+        std::function<TIMESTAMP_TYPE()> expiry_cutoff_;
+        expiry_stats expired_;
+        bool reading_ = false;
 
         // Disallow copy, assign and move
 
@@ -159,46 +577,91 @@ namespace containers {
 
         // Become a friend of transactions
 
-        friend class transaction_base<TIMESTAMP_TYPE>;
-        friend class read_transaction<TIMESTAMP_TYPE>;
-        friend class write_transaction<TIMESTAMP_TYPE>;
+        friend class transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>;
+        friend class read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+        friend class write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+        friend class read_batch<TIMESTAMP_TYPE, SIZE_TYPE>;
+        friend class elastic_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>;  // check 'writing_' / 'reading_'
+        friend class spilling_transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>; // (and 'end_')
 
         // Initialization
 
-        void set_buffer(uint8_t* _memory, uint32_t _capacity);
+        void set_buffer(uint8_t* _memory, SIZE_TYPE _capacity, memory_layout _layout, bool _resume = false);
+        void free_memory();
+        static auto map_mirrored(SIZE_TYPE _capacity) -> uint8_t*;
+        static auto shared_data_offset() -> size_t;
+        auto map_control(int _fd, SIZE_TYPE _capacity, memory_layout _layout) -> bool;
+        auto recover() -> bool;
+        void sync_if_due(); // producer only
+#if defined(__linux__)
+        static auto write_all(int _fd, iovec* _segments, int _count) -> uint64_t; // bytes written (fewer on error)
+#endif
 
         // Low-level read / write memory blocks and arithmetic values (no availability checks)
 
-        void llwrite(uint32_t _idx, const uint8_t* _src, uint32_t _size);
-        void llread (uint32_t _idx, uint8_t* _dest, uint32_t _size);
+        void llwrite(SIZE_TYPE _idx, const uint8_t* _src, SIZE_TYPE _size);
+        void llread (SIZE_TYPE _idx, uint8_t* _dest, SIZE_TYPE _size);
 
         template<typename T, typename U = void> using iff_arith_t     = typename std::enable_if< std::is_arithmetic<T>::value, U>::type;
         template<typename T, typename U = void> using iff_not_arith_t = typename std::enable_if<!std::is_arithmetic<T>::value, U>::type;
 
-        template<typename T> auto llwrite(uint32_t _idx, const T& _src)  -> iff_arith_t<T>;
-        template<typename T> auto llwrite(uint32_t _idx, const T& _src)  -> iff_not_arith_t<T>;
-        template<typename T> auto llread (uint32_t _idx,       T& _dest) -> iff_arith_t<T>;
-        template<typename T> auto llread (uint32_t _idx,       T& _dest) -> iff_not_arith_t<T>;
+        template<typename T> auto llwrite(SIZE_TYPE _idx, const T& _src)  -> iff_arith_t<T>;
+        template<typename T> auto llwrite(SIZE_TYPE _idx, const T& _src)  -> iff_not_arith_t<T>;
+        template<typename T> auto llread (SIZE_TYPE _idx,       T& _dest) -> iff_arith_t<T>;
+        template<typename T> auto llread (SIZE_TYPE _idx,       T& _dest) -> iff_not_arith_t<T>;
 
         // helpers
 
-        auto index_of(uint32_t _index) const -> uint32_t;
-        auto round_up(uint32_t _index) const -> uint32_t;
+        auto index_of(uint64_t _position) const -> SIZE_TYPE;
+        auto writable(SIZE_TYPE _wanted) -> SIZE_TYPE; // producer only
+        auto make_room(SIZE_TYPE _wanted) -> SIZE_TYPE; // producer only (overwrite mode)
+        void catch_up();                             // consumer only (overwrite mode)
+        auto overwritten(uint64_t _position) const -> bool; // consumer only (overwrite mode)
+        auto span_at(uint64_t _position, bool& _transaction) -> SIZE_TYPE;
+        auto skip_older(TIMESTAMP_TYPE _timestamp, uint64_t& _count) -> bool; // consumer only
+        auto readable() -> SIZE_TYPE;                 // consumer only
+        void pad();                                  // producer only ('padded' layout)
+        void skip_padding();                         // consumer only
+        void committed(SIZE_TYPE _size);              // producer only
+        void publish_head();                         // consumer only
+        auto publish_expired() const -> bool;        // producer only
+        void notify(std::atomic<uint64_t>& _position, std::atomic<uint32_t>& _waiters, std::atomic<bool>& _armed, int _fd);
+        auto arm(std::atomic<bool>& _armed, std::atomic<uint64_t>& _position) -> uint64_t;
+        void index_transaction(SIZE_TYPE _size, TIMESTAMP_TYPE _timestamp); // producer only
+        auto round_up(SIZE_TYPE _index) const -> SIZE_TYPE;
     };
 
     // == Constants and global structs ========
 
-    static constexpr uint32_t INVALID_INDEX = 0xFFffFFff;
+    static constexpr uint32_t INVALID_INDEX = size_traits<uint32_t>::INVALID_INDEX;
+    static constexpr uint32_t PADDING_FLAG  = size_traits<uint32_t>::PADDING_FLAG;
 
-    template<typename TIMESTAMP_TYPE>
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE = uint32_t>
     struct transaction_header {
-        uint32_t size;
+        SIZE_TYPE size;
         TIMESTAMP_TYPE timestamp;
     };
 
+    /*
+        View of ring memory
+
+        - 'second' is only used when the data crosses the end of a 'ring' buffer (nullptr / 0 otherwise)
+        - an empty view (first == nullptr) means that the operation failed
+    */
+    template<typename T, typename SIZE_TYPE = uint32_t>
+    struct ring_span {
+        T* first;
+        SIZE_TYPE first_size;
+        T* second;
+        SIZE_TYPE second_size;
+
+        auto size() const -> SIZE_TYPE { return first_size + second_size; }
+        explicit operator bool() const { return first != nullptr; }
+    };
+
     // == Base of all transactions ========
 
-    template<typename TIMESTAMP_TYPE>
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
     class transaction_base {
 
     public:
@@ -213,24 +676,24 @@ namespace containers {
               (except for the 'operator bool')
         */
         explicit operator bool() const;
-        auto size() const -> uint32_t;
+        auto size() const -> SIZE_TYPE;
         auto timestamp() const -> TIMESTAMP_TYPE;
         static constexpr auto header_size() -> uint32_t;
 
     protected:
 
-        transaction_base(transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer);
+        transaction_base(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer);
 
-        transaction_header<TIMESTAMP_TYPE> header_;
-        transactional_ring_buffer<TIMESTAMP_TYPE>& buffer_;
-        uint32_t index_; // index on the ring buffer
-        uint32_t available_;
+        transaction_header<TIMESTAMP_TYPE, SIZE_TYPE> header_;
+        transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& buffer_;
+        SIZE_TYPE index_; // index on the ring buffer
+        SIZE_TYPE available_;
     };
 
     // == Write transaction ========
 
-    template<typename TIMESTAMP_TYPE>
-    class write_transaction : public transaction_base<TIMESTAMP_TYPE> {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    class write_transaction : public transaction_base<TIMESTAMP_TYPE, SIZE_TYPE> {
 
     public:
 
@@ -245,7 +708,7 @@ namespace containers {
             - write transactions can be moved but not copied
             - destructor shall commit changes
         */
-        write_transaction(transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer, TIMESTAMP_TYPE _timestamp);
+        write_transaction(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer, TIMESTAMP_TYPE _timestamp, SIZE_TYPE _min_size = 0);
         write_transaction(const write_transaction& _other) = delete;
         write_transaction(write_transaction&& _other);
         ~write_transaction();
@@ -256,11 +719,22 @@ namespace containers {
             - the failure of the operations does not invalidate the whole transaction.
             - on simple 'push_back' the operation occurs completely or not (no partial additions)
             - on variadic 'push_backs' it is added as many as it can and returns the number of successfully added items
+            - 'reserve_span' returns writable ring memory for the next '_size' bytes (zero-copy writes) and
+              'advance' adds '_size' (<= the reserved size) of those bytes to the transaction.
+              The span is valid until the next data operation
+            - 'read_from' (linux only) appends up to '_max_size' bytes read from '_fd' with a single 'readv' into the
+              free ring memory (no intermediate copies). It returns the bytes appended, 0 on end of file or -1 on
+              error (errno is ENOBUFS when there is no room). Nothing is appended on error
             - commit is not mandatory as destructor shall call it automatically
         */
 
         // raw memory
-        auto push_back(const uint8_t* _data, const uint32_t _size) -> bool;
+        auto push_back(const uint8_t* _data, const SIZE_TYPE _size) -> bool;
+
+        // in-place
+        auto reserve_span(const SIZE_TYPE _size) -> ring_span<uint8_t, SIZE_TYPE>;
+        auto advance(const SIZE_TYPE _size) -> bool;
+        auto read_from(int _fd, SIZE_TYPE _max_size) -> int64_t;
 
         // single
         template<typename T>
@@ -274,13 +748,16 @@ namespace containers {
 
     private:
 
-        auto can_write(const uint32_t _size) -> bool;
+        auto can_write(const SIZE_TYPE _size) -> bool;
+        auto relocate(const SIZE_TYPE _size) -> bool;
+
+        SIZE_TYPE reserved_; // bytes handed out by the last 'reserve_span'
     };
 
     // == Read transaction ========
 
-    template<typename TIMESTAMP_TYPE>
-    class read_transaction : public transaction_base<TIMESTAMP_TYPE> {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    class read_transaction : public transaction_base<TIMESTAMP_TYPE, SIZE_TYPE> {
 
     public:
 
@@ -295,7 +772,7 @@ namespace containers {
             - read transactions can be moved but not copied
             - destructor shall commit changes
         */
-        read_transaction(transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer);
+        read_transaction(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer);
         read_transaction(const read_transaction& _other) = delete;
         read_transaction(read_transaction&& _other);
         ~read_transaction();
@@ -307,114 +784,253 @@ namespace containers {
             - no partial reads occur. All or nothing.
             - "sized" read operations can happen in up to 2 rounds (2 calls to lambda)
               The lambda receives a buffer/size with the partial read
+              (always 1 round on 'mirrored' and 'padded' buffers)
+            - "sized" read operations take any callable so that it can be inlined; the 'std::function'
+              version is kept as a fallback (an empty one just skips the data)
+            - zero-copy operations alias the ring memory and are valid until the transaction commits:
+              - 'peek' returns the next T without consuming it. It returns nullptr if there is not enough
+                data or if T crosses the end of a 'ring' buffer (use 'pop_front' then). The pointer might be unaligned
+              - 'view' consumes the next '_size' bytes and returns them as up to 2 chunks
+              - 'write_to' (linux only) writes the next '_size' bytes (the rest of the payload by default) to '_fd'
+                with 'writev' over the ring memory and consumes them. It returns the bytes written or -1 if there
+                are not enough bytes or on error; then nothing is consumed (though some might have been written)
             - 'commit' is a manual version of the destructor
+            - 'clobbered' (overwrite mode) is true if the producer overwrote the transaction after it was created
         */
         template<typename T> auto pop_front() -> std::pair<T, bool>;
         template<typename T> auto pop_front(T& _dest) -> bool;
-        auto pop_front(uint32_t _size, std::function<void(const uint8_t*, uint32_t)> _callback) -> bool;
+        auto pop_front(SIZE_TYPE _size, std::function<void(const uint8_t*, SIZE_TYPE)> _callback) -> bool;
+
+        template<typename CALLBACK>
+        auto pop_front(SIZE_TYPE _size, CALLBACK&& _callback) -> typename std::enable_if<std::is_invocable<CALLBACK, const uint8_t*, SIZE_TYPE>::value, bool>::type;
+
+        template<typename T> auto peek() -> const T*;
+        auto view(SIZE_TYPE _size) -> ring_span<const uint8_t, SIZE_TYPE>;
+        auto write_to(int _fd, SIZE_TYPE _size = size_traits<SIZE_TYPE>::INVALID_INDEX) -> int64_t;
+        auto clobbered() const -> bool;
+
+        void commit();
+
+    private:
+
+        friend class read_batch<TIMESTAMP_TYPE, SIZE_TYPE>;
+
+        read_transaction(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer, read_batch<TIMESTAMP_TYPE, SIZE_TYPE>* _batch);
+        void read_header();
+
+        read_batch<TIMESTAMP_TYPE, SIZE_TYPE>* batch_ = nullptr; // only on batched reads (see 'drain')
+
+        auto can_read(SIZE_TYPE _bytes) -> bool;
+
+        template<typename CALLBACK>
+        auto pop_chunks(SIZE_TYPE _size, CALLBACK& _callback) -> bool;
+    };
+
+    // == Batch of read transactions ========
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    class read_batch {
+
+    public:
+
+        /*
+            Iteration (range-for)
+
+            - dereferencing creates the next read transaction. It must be committed (or destroyed)
+              before advancing to the next one
+        */
+        class iterator {
+        public:
+            auto operator*() -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+            auto operator++() -> iterator&;
+            auto operator!=(const iterator& _other) const -> bool;
+        private:
+            friend class read_batch;
+            iterator(read_batch* _batch) : batch_(_batch) {}
+            read_batch* batch_;
+        };
+
+        auto begin() -> iterator;
+        auto end()   -> iterator;
+
+        /*
+            Getters
+
+            - 'operator bool' shall be false if the batch could not be created (no data or another read in progress)
+            - 'count' / 'bytes' are the amount of transactions / bytes consumed so far
+        */
+        explicit operator bool() const;
+        auto count() const -> uint32_t;
+        auto bytes() const -> uint64_t;
+
+        /*
+            Construction
+
+            - batches can be moved but not copied
+            - destructor shall publish the consumed position
+        */
+        read_batch(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer, uint32_t _max_count, uint64_t _max_bytes);
+        read_batch(const read_batch& _other) = delete;
+        read_batch(read_batch&& _other);
+        ~read_batch();
 
         void commit();
 
     private:
 
-        auto can_read(uint32_t _bytes) -> bool;
+        friend class read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>;
+
+        auto has_next() -> bool;
+
+        transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& buffer_;
+        uint64_t limit_;   // snapshot of the tail
+        uint32_t max_count_, count_ = 0;
+        uint64_t max_bytes_, bytes_ = 0;
+        bool valid_ = false, stopped_ = false;
     };
 
     // == implementation of transactions ========
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline transaction_base<TIMESTAMP_TYPE>::transaction_base(transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer) : buffer_(_buffer), index_(INVALID_INDEX) {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>::transaction_base(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer) : buffer_(_buffer), index_(size_traits<SIZE_TYPE>::INVALID_INDEX) {
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline transaction_base<TIMESTAMP_TYPE>::operator bool() const {
-        return index_ != INVALID_INDEX;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>::operator bool() const {
+        return index_ != size_traits<SIZE_TYPE>::INVALID_INDEX;
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto transaction_base<TIMESTAMP_TYPE>::size() const -> uint32_t {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>::size() const -> SIZE_TYPE {
         //assert((bool)*this); // TODO: Add debug checks
         return header_.size - header_size();
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto transaction_base<TIMESTAMP_TYPE>::timestamp() const -> TIMESTAMP_TYPE {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>::timestamp() const -> TIMESTAMP_TYPE {
         //assert((bool)*this); // TODO: Add debug checks
         return header_.timestamp;
     }
 
-    template<typename TIMESTAMP_TYPE>
-    constexpr auto transaction_base<TIMESTAMP_TYPE>::header_size() -> uint32_t {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    constexpr auto transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>::header_size() -> uint32_t {
         // note: do not change this to the size of the struct as it might have padding
-        return sizeof (transaction_header<TIMESTAMP_TYPE>::size) + sizeof (transaction_header<TIMESTAMP_TYPE>::timestamp);
+        return sizeof (transaction_header<TIMESTAMP_TYPE, SIZE_TYPE>::size) + sizeof (transaction_header<TIMESTAMP_TYPE, SIZE_TYPE>::timestamp);
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline void write_transaction<TIMESTAMP_TYPE>::invalidate() {
-        this->index_ = INVALID_INDEX;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::invalidate() {
+        this->index_ = size_traits<SIZE_TYPE>::INVALID_INDEX;
         this->buffer_.writing_ = false;
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline write_transaction<TIMESTAMP_TYPE>::write_transaction(write_transaction&& _other) : transaction_base<TIMESTAMP_TYPE>(_other.buffer_) {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::write_transaction(write_transaction&& _other) : transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>(_other.buffer_) {
         this->header_.size = _other.header_.size;
         this->header_.timestamp = _other.header_.timestamp;
         this->index_ = _other.index_;
         this->available_ = _other.available_;
+        reserved_ = _other.reserved_;
 
-        _other.invalidate();
+        _other.index_ = size_traits<SIZE_TYPE>::INVALID_INDEX; // note: not 'invalidate' as the buffer is still being written by this one
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline write_transaction<TIMESTAMP_TYPE>::write_transaction(transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer, TIMESTAMP_TYPE _timestamp) : transaction_base<TIMESTAMP_TYPE>(_buffer) {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::write_transaction(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer, TIMESTAMP_TYPE _timestamp, SIZE_TYPE _min_size) : transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>(_buffer), reserved_(0) {
         if (_buffer && !this->buffer_.writing_) {
             this->header_.size = this->header_size();
-            auto actual_available_size = this->buffer_.capacity_ - this->buffer_.size_.load(std::memory_order_acquire);
-            if (actual_available_size >= this->header_.size) {
+            const auto needed = this->header_.size + _min_size;
+
+            // on 'padded' buffers a transaction that does not fit before the end starts at the beginning
+            if (this->buffer_.layout_ == memory_layout::padded) {
+                auto padding = this->buffer_.capacity_ - this->buffer_.index_of(this->buffer_.end_);
+                if (needed > padding) {
+                    if (needed > this->buffer_.capacity_ || this->buffer_.writable(padding) < padding) {
+                        return;
+                    }
+                    this->buffer_.pad();
+                }
+            }
+
+            auto actual_available_size = this->buffer_.writable(needed);
+            if (actual_available_size >= needed) {
+                auto start = this->buffer_.end_;
                 this->available_ = actual_available_size - this->header_.size;
                 this->header_.timestamp = _timestamp;
-                this->buffer_.llwrite(this->buffer_.index_of(this->buffer_.end_ + sizeof(this->header_.size)), _timestamp); // transaction size gap will be filled on the destructor
-                this->index_ = this->buffer_.index_of(this->buffer_.end_ + this->header_size());
+                this->buffer_.llwrite(this->buffer_.index_of(start + sizeof(this->header_.size)), _timestamp); // transaction size gap will be filled on the destructor
+                this->index_ = this->buffer_.index_of(start + this->header_size());
 
                 this->buffer_.writing_ = true;
             }
         }
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline write_transaction<TIMESTAMP_TYPE>::~write_transaction() {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::~write_transaction() {
         commit();
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline void write_transaction<TIMESTAMP_TYPE>::commit() {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::commit() {
         if (*this) {
-            this->buffer_.llwrite(this->buffer_.end_, reinterpret_cast<const uint8_t*>(&this->header_.size), sizeof(this->header_.size));
-            this->buffer_.end_ = this->buffer_.index_of(this->buffer_.end_ + this->header_.size);
-            this->buffer_.size_.fetch_add(this->header_.size, std::memory_order_release);
+            this->buffer_.llwrite(this->buffer_.index_of(this->buffer_.end_), reinterpret_cast<const uint8_t*>(&this->header_.size), sizeof(this->header_.size));
+            if (this->buffer_.index_) {
+                this->buffer_.index_transaction(this->header_.size, this->header_.timestamp);
+            }
+            this->buffer_.end_ += this->header_.size;
+            this->buffer_.committed(this->header_.size);
             this->invalidate();
         }
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto write_transaction<TIMESTAMP_TYPE>::can_write(const uint32_t _size) -> bool {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::can_write(const SIZE_TYPE _size) -> bool {
+        reserved_ = 0; // any data operation invalidates previous spans
         if (!*this) {
             return false;
         }
 
         // 'available_' is cached from when the transaction was generated. Try to sync it again before failing
         if (this->available_ < _size) {
-            this->available_ = this->buffer_.capacity_ - this->buffer_.size_.load(std::memory_order_acquire) - this->header_.size;
+            this->available_ = this->buffer_.writable(this->header_.size + _size) - this->header_.size;
             if (this->available_ < _size) {
                 return false;
             }
         }
 
+        // 'padded' buffers: the transaction cannot cross the end of the buffer
+        if (this->buffer_.layout_ == memory_layout::padded && this->buffer_.index_of(this->buffer_.end_) + this->header_.size + _size > this->buffer_.capacity_) {
+            return relocate(_size);
+        }
+
         return true;
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto write_transaction<TIMESTAMP_TYPE>::push_back(const uint8_t* _data, const uint32_t _size) -> bool {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    auto write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::relocate(const SIZE_TYPE _size) -> bool {
+        /*
+            Move what we have written so far to the beginning of the buffer and pad the rest. It waits for the
+            consumer to release the beginning, not the whole transaction: the padding is published first
+            note: it cannot move what would overlap itself (more bytes than there are before the transaction)
+        */
+        auto start = this->buffer_.index_of(this->buffer_.end_);
+        if (start == 0 || this->header_.size > start) {
+            return false;
+        }
+        auto gap = this->buffer_.capacity_ - start;
+        if (this->buffer_.writable(gap + this->header_.size) < gap + this->header_.size) {
+            return false;
+        }
+
+        memcpy(&this->buffer_.memory_[0], &this->buffer_.memory_[start], this->header_.size);
+        this->buffer_.pad();
+        this->index_ = this->header_.size;
+        this->available_ = this->buffer_.writable(this->header_.size + _size) - this->header_.size;
+        return this->available_ >= _size;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::push_back(const uint8_t* _data, const SIZE_TYPE _size) -> bool {
         if (!can_write(_size)) {
             return false;
         }
@@ -427,9 +1043,78 @@ namespace containers {
         return true;
     }
 
-    template<typename TIMESTAMP_TYPE>
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::reserve_span(const SIZE_TYPE _size) -> ring_span<uint8_t, SIZE_TYPE> {
+        if (!can_write(_size)) {
+            return { nullptr, 0, nullptr, 0 };
+        }
+
+        reserved_ = _size;
+        auto first_size = std::min(_size, this->buffer_.linear_size_ - this->index_);
+        if (first_size == _size) {
+            return { &this->buffer_.memory_[this->index_], _size, nullptr, 0 };
+        }
+        return { &this->buffer_.memory_[this->index_], first_size, &this->buffer_.memory_[0], _size - first_size };
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::advance(const SIZE_TYPE _size) -> bool {
+        if (!*this || _size > reserved_) {
+            return false;
+        }
+
+        this->index_ = this->buffer_.index_of(this->index_ + _size);
+        this->available_ -= _size;
+        this->header_.size += _size;
+        reserved_ = 0;
+
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::read_from(int _fd, SIZE_TYPE _max_size) -> int64_t {
+#if defined(__linux__)
+        if (!*this) {
+            return -1;
+        }
+
+        // as much of '_max_size' as there is room for ('available_' might be stale). Clamped first: the maximum
+        // value means "as much as fits" and would wrap around below
+        auto max_size = (SIZE_TYPE)std::min<uint64_t>(_max_size, this->buffer_.capacity_ - this->header_.size);
+        auto size = std::min(max_size, this->available_);
+        if (size < max_size) {
+            this->available_ = this->buffer_.writable(this->header_.size + max_size) - this->header_.size;
+            size = std::min(max_size, this->available_);
+        }
+        auto span = reserve_span(size);
+        if (!span && this->buffer_.layout_ == memory_layout::padded) {
+            size = std::min(size, this->buffer_.capacity_ - this->index_); // could not relocate: up to the end
+            span = reserve_span(size);
+        }
+        if (!span || size == 0) {
+            errno = ENOBUFS;
+            return -1;
+        }
+
+        iovec segments[2] = { { span.first, span.first_size }, { span.second, span.second_size } };
+        ssize_t bytes;
+        do {
+            bytes = readv(_fd, segments, span.second ? 2 : 1);
+        } while (bytes < 0 && errno == EINTR);
+        if (bytes > 0) {
+            advance((SIZE_TYPE)bytes);
+        }
+        reserved_ = 0;
+        return bytes;
+#else
+        (void)_fd; (void)_max_size;
+        return -1;
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
     template<typename T>
-    forceinline auto write_transaction<TIMESTAMP_TYPE>::push_back(const T& _data) -> bool {
+    forceinline auto write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::push_back(const T& _data) -> bool {
         if (!can_write(sizeof(T))) {
             return false;
         }
@@ -442,89 +1127,292 @@ namespace containers {
         return true;
     }
 
-    template<typename TIMESTAMP_TYPE>
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
     template<typename T, typename ...REST>
-    forceinline auto write_transaction<TIMESTAMP_TYPE>::push_back(const T& _item, REST... _rest) -> typename std::enable_if<!std::is_pointer<T>::value, int>::type {
+    forceinline auto write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::push_back(const T& _item, REST... _rest) -> typename std::enable_if<!std::is_pointer<T>::value, int>::type {
         if (!push_back(_item)) {
             return 0;
         }
         return 1 + push_back(_rest...);
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline read_transaction<TIMESTAMP_TYPE>::read_transaction(read_transaction&& _other) : transaction_base<TIMESTAMP_TYPE>(_other.buffer_) {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::read_transaction(read_transaction&& _other) : transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>(_other.buffer_) {
         this->header_.size = _other.header_.size;
         this->header_.timestamp = _other.header_.timestamp;
         this->index_ = _other.index_;
         this->available_ = _other.available_;
+        batch_ = _other.batch_;
 
-        _other.invalidate();
+        _other.index_ = size_traits<SIZE_TYPE>::INVALID_INDEX; // note: not 'invalidate' as the buffer is still being read by this one
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::read_transaction(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer) : transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>(_buffer) {
+        if (_buffer && !this->buffer_.reading_) {
+            if (this->buffer_.overwrite_) {
+                this->buffer_.catch_up();
+            }
+            if (this->buffer_.readable() > 0) { // note: as transactions are atomic we just need to check that there is some data
+                read_header();
+                this->buffer_.reading_ = (bool)*this;
+            }
+        }
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline read_transaction<TIMESTAMP_TYPE>::read_transaction(transactional_ring_buffer<TIMESTAMP_TYPE>& _buffer) : transaction_base<TIMESTAMP_TYPE>(_buffer) {
-        if (_buffer) {
-            if (!this->buffer_.reading_ && this->buffer_.size_.load(std::memory_order_acquire) > 0) { // note: as transactions are atomic we just need to check that the buffer size is greater than zero
-                this->buffer_.llread(this->buffer_.start_,                                                      this->header_.size);
-                this->buffer_.llread(this->buffer_.index_of(this->buffer_.start_ + sizeof(this->header_.size)), this->header_.timestamp);
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::read_transaction(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer, read_batch<TIMESTAMP_TYPE, SIZE_TYPE>* _batch) : transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>(_buffer), batch_(_batch) {
+        read_header(); // the batch already checked that there is data
+    }
 
-                this->index_ = this->buffer_.index_of(this->buffer_.start_ + this->header_size());
-                this->available_ = this->header_.size - this->header_size();
-                this->buffer_.reading_ = true;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::read_header() {
+        const auto from = this->buffer_.start_;
+        if (this->buffer_.layout_ == memory_layout::padded) {
+            this->buffer_.skip_padding();
+            if (this->buffer_.start_ == this->buffer_.tail_cache_) {
+                // padding published on its own (the next transaction waits for room at the beginning)
+                if (this->buffer_.overwrite_ && this->buffer_.overwritten(from)) {
+                    this->buffer_.start_ = from;
+                } else if (!batch_) {
+                    this->buffer_.publish_head();
+                }
+                return;
+            }
+        }
+        this->buffer_.llread(this->buffer_.index_of(this->buffer_.start_),                              this->header_.size);
+        this->buffer_.llread(this->buffer_.index_of(this->buffer_.start_ + sizeof(this->header_.size)), this->header_.timestamp);
+
+        this->index_ = this->buffer_.index_of(this->buffer_.start_ + this->header_size());
+        this->available_ = this->header_.size - this->header_size();
+
+        // overwrite mode: the header (or the padding before it) might be torn
+        if (this->buffer_.overwrite_ && this->buffer_.overwritten(from)) {
+            this->buffer_.start_ = from;
+            this->index_ = size_traits<SIZE_TYPE>::INVALID_INDEX;
+            if (batch_) {
+                batch_->stopped_ = true;
             }
         }
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline void read_transaction<TIMESTAMP_TYPE>::invalidate() {
-        this->index_ = INVALID_INDEX;
-        this->buffer_.reading_ = false;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::clobbered() const -> bool {
+        return this->buffer_.overwrite_ && this->buffer_.overwritten(this->buffer_.start_);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::invalidate() {
+        if (batch_) {
+            batch_->stopped_ |= (bool)*this;
+        } else {
+            this->buffer_.reading_ = false;
+        }
+        this->index_ = size_traits<SIZE_TYPE>::INVALID_INDEX;
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline read_transaction<TIMESTAMP_TYPE>::~read_transaction() {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::~read_transaction() {
         commit();
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline void read_transaction<TIMESTAMP_TYPE>::commit() {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::commit() {
         if (*this) {
-            this->buffer_.start_ = this->buffer_.index_of(this->buffer_.start_ + this->header_.size);
-            this->buffer_.size_.fetch_sub(this->header_.size, std::memory_order_release);
-            this->buffer_.reading_ = false;
-            this->index_ = INVALID_INDEX;
+            this->buffer_.start_ += this->header_.size;
+            if (batch_) {
+                batch_->count_++;
+                batch_->bytes_ += this->header_.size;
+            } else {
+                this->buffer_.publish_head();
+                this->buffer_.reading_ = false;
+            }
+            this->index_ = size_traits<SIZE_TYPE>::INVALID_INDEX;
+        }
+    }
+
+    // == implementation of batches ========
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::read_batch(transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>& _buffer, uint32_t _max_count, uint64_t _max_bytes) : buffer_(_buffer), max_count_(_max_count), max_bytes_(_max_bytes) {
+        if (_buffer && !buffer_.reading_) {
+            if (buffer_.overwrite_) {
+                buffer_.catch_up();
+            }
+            limit_ = buffer_.tail_cache_ = buffer_.control_->tail.load(std::memory_order_acquire); // single snapshot for the whole batch
+            if (limit_ == buffer_.start_ && buffer_.data_fd_ != -1) {
+                limit_ = buffer_.tail_cache_ = buffer_.arm(buffer_.control_->data_armed, buffer_.control_->tail);
+            }
+            valid_ = limit_ != buffer_.start_;
+            buffer_.reading_ = valid_;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::read_batch(read_batch&& _other) : buffer_(_other.buffer_), limit_(_other.limit_), max_count_(_other.max_count_), count_(_other.count_), max_bytes_(_other.max_bytes_), bytes_(_other.bytes_), valid_(_other.valid_), stopped_(_other.stopped_) {
+        _other.valid_ = false;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::~read_batch() {
+        commit();
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::commit() {
+        if (valid_) {
+            buffer_.publish_head();
+            buffer_.reading_ = false;
+            valid_ = false;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::has_next() -> bool {
+        if (valid_ && !stopped_ && buffer_.layout_ == memory_layout::padded && buffer_.start_ != limit_) {
+            // do not hand out a transaction for padding published on its own
+            const auto from = buffer_.start_;
+            buffer_.skip_padding();
+            if (buffer_.overwrite_ && buffer_.overwritten(from)) {
+                buffer_.start_ = from;
+                stopped_ = true;
+            }
         }
+        return valid_ && !stopped_ && count_ < max_count_ && bytes_ < max_bytes_ && buffer_.start_ != limit_;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::begin() -> iterator {
+        return iterator(this);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::end() -> iterator {
+        return iterator(nullptr);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::operator bool() const {
+        return valid_;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::count() const -> uint32_t {
+        return count_;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::bytes() const -> uint64_t {
+        return bytes_;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::iterator::operator*() -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE> {
+        return read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>(batch_->buffer_, batch_);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::iterator::operator++() -> iterator& {
+        return *this; // the transaction moves the position on commit
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_batch<TIMESTAMP_TYPE, SIZE_TYPE>::iterator::operator!=(const iterator&) const -> bool {
+        return batch_ && batch_->has_next();
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto read_transaction<TIMESTAMP_TYPE>::can_read(uint32_t _bytes) -> bool {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::can_read(SIZE_TYPE _bytes) -> bool {
         return (bool)*this && this->available_ >= _bytes;
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto read_transaction<TIMESTAMP_TYPE>::pop_front(uint32_t _size, std::function<void(const uint8_t*const, uint32_t)> _callback) -> bool {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::pop_front(SIZE_TYPE _size, std::function<void(const uint8_t*const, SIZE_TYPE)> _callback) -> bool {
+        if (!_callback) {
+            auto skip = [](const uint8_t*, SIZE_TYPE) {};
+            return pop_chunks(_size, skip);
+        }
+        return pop_chunks(_size, _callback);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    template<typename CALLBACK>
+    forceinline auto read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::pop_front(SIZE_TYPE _size, CALLBACK&& _callback) -> typename std::enable_if<std::is_invocable<CALLBACK, const uint8_t*, SIZE_TYPE>::value, bool>::type {
+        return pop_chunks(_size, _callback);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    template<typename CALLBACK>
+    forceinline auto read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::pop_chunks(SIZE_TYPE _size, CALLBACK& _callback) -> bool {
         if (!can_read(_size)) {
             return false;
         }
 
         auto size = std::min(this->available_, _size);
-        if (_callback) {
-            if ((this->index_ + size) <= this->buffer_.capacity_) {
-                _callback(reinterpret_cast<const uint8_t*>(&this->buffer_.memory_[this->index_]), size);
-            } else {
-                auto first_chunk_size = this->buffer_.capacity_ - this->index_;
-                _callback(reinterpret_cast<const uint8_t*>(&this->buffer_.memory_[this->index_]), first_chunk_size);
-                _callback(reinterpret_cast<const uint8_t*>(&this->buffer_.memory_[0]), size - first_chunk_size);
-            }
+        if ((this->index_ + size) <= this->buffer_.linear_size_) { // always true on mirrored buffers
+            _callback(reinterpret_cast<const uint8_t*>(&this->buffer_.memory_[this->index_]), size);
+        } else {
+            auto first_chunk_size = this->buffer_.capacity_ - this->index_;
+            _callback(reinterpret_cast<const uint8_t*>(&this->buffer_.memory_[this->index_]), first_chunk_size);
+            _callback(reinterpret_cast<const uint8_t*>(&this->buffer_.memory_[0]), size - first_chunk_size);
         }
         this->index_ = this->buffer_.index_of(this->index_ + size);
         this->available_ -= size;
         return true;
     }
 
-    template<typename TIMESTAMP_TYPE>
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    template<typename T>
+    forceinline auto read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::peek() -> const T* {
+        static_assert(std::is_pod<T>::value, "Only POD types can be peeked");
+        if (!can_read(sizeof(T)) || this->index_ + sizeof(T) > this->buffer_.linear_size_) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(&this->buffer_.memory_[this->index_]);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::view(SIZE_TYPE _size) -> ring_span<const uint8_t, SIZE_TYPE> {
+        if (!can_read(_size)) {
+            return { nullptr, 0, nullptr, 0 };
+        }
+
+        auto idx = this->index_;
+        this->index_ = this->buffer_.index_of(this->index_ + _size);
+        this->available_ -= _size;
+
+        auto first_size = std::min(_size, this->buffer_.linear_size_ - idx);
+        if (first_size == _size) {
+            return { &this->buffer_.memory_[idx], _size, nullptr, 0 };
+        }
+        return { &this->buffer_.memory_[idx], first_size, &this->buffer_.memory_[0], _size - first_size };
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::write_to(int _fd, SIZE_TYPE _size) -> int64_t {
+#if defined(__linux__)
+        auto size = _size == size_traits<SIZE_TYPE>::INVALID_INDEX ? this->available_ : _size;
+        if (!can_read(size)) {
+            return -1;
+        }
+
+        auto first_size = std::min(size, this->buffer_.linear_size_ - this->index_);
+        iovec segments[2] = { { &this->buffer_.memory_[this->index_], first_size }, { &this->buffer_.memory_[0], size - first_size } };
+        if (this->buffer_.write_all(_fd, segments, first_size == size ? 1 : 2) != size) {
+            return -1;
+        }
+        this->index_ = this->buffer_.index_of(this->index_ + size);
+        this->available_ -= size;
+        return size;
+#else
+        (void)_fd; (void)_size;
+        return -1;
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
     template<typename T>
-    forceinline auto read_transaction<TIMESTAMP_TYPE>::pop_front() -> std::pair<T, bool> {
+    forceinline auto read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::pop_front() -> std::pair<T, bool> {
         T value;
         if (!can_read(sizeof(T))) {
             return std::make_pair(value, false);
@@ -535,9 +1423,9 @@ namespace containers {
         return std::make_pair(value, true);
     }
 
-    template<typename TIMESTAMP_TYPE>
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
     template<typename T>
-    forceinline auto read_transaction<TIMESTAMP_TYPE>::pop_front(T& _dest) -> bool {
+    forceinline auto read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>::pop_front(T& _dest) -> bool {
         if (!can_read(sizeof(T))) {
             return false;
         }
@@ -551,81 +1439,724 @@ namespace containers {
 
     // Construction / destruction / set_buffer
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline transactional_ring_buffer<TIMESTAMP_TYPE>::~transactional_ring_buffer() {
-        if (own_memory_ && memory_) {
-            delete[] memory_;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::~transactional_ring_buffer() {
+        if (own_memory_) {
+            free_memory();
+        }
+        delete[] index_;
+#if defined(__linux__)
+        for (auto fd : { data_fd_, room_fd_ }) {
+            if (fd != -1) {
+                close(fd);
+            }
         }
+#endif
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE>::set_buffer(uint8_t* _memory, uint32_t _capacity) {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::set_buffer(uint8_t* _memory, SIZE_TYPE _capacity, memory_layout _layout, bool _resume) {
+        // '_resume' keeps the published positions (attaching to a shared buffer) instead of resetting them
         memory_ = _memory;
         capacity_ = _capacity;
         capacity_mask_ = capacity_ - 1;
-        start_ = end_ = 0;
+        layout_ = _layout;
+        linear_size_ = _layout == memory_layout::mirrored ? 2 * capacity_ : capacity_;
+        if (!_resume) {
+            control_->index_count.store(0, std::memory_order_relaxed);
+            control_->oldest.store(0, std::memory_order_relaxed);
+            control_->lost.store(0, std::memory_order_relaxed);
+            control_->head.store(0, std::memory_order_relaxed);
+            control_->tail.store(0, std::memory_order_release);
+        }
+        start_ = head_cache_ = tail_cache_ = control_->head.load(std::memory_order_acquire);
+        end_ = synced_end_ = control_->tail.load(std::memory_order_acquire);
+        if (overwrite_) {
+            head_cache_ = control_->oldest.load(std::memory_order_relaxed);
+        }
+        padding_size_ = 0;
+        pending_count_ = pending_bytes_ = 0;
+        index_end_ = index_start_ = 0;
+        index_since_count_ = index_every_count_;
+        index_since_bytes_ = 0;
         valid_ = memory_ != nullptr;
     }
 
     // Memory allocation / borrowing
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::reserve(uint32_t _wanted_capacity) -> bool {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::reserve(SIZE_TYPE _wanted_capacity, memory_layout _layout) -> bool {
         if (!own_memory_) {
             return false; // 'borrow' called before
         }
+        if (_wanted_capacity > max_capacity(_layout)) {
+            return false; // 'round_up' would wrap around
+        }
 
         /*
             note: On same or less capacity we do not need to deallocate; Just adjustments.
+                  Mirrored mappings cannot be partially used, hence, they are only reused on the same capacity.
         */
 
         auto new_capacity = round_up(_wanted_capacity < min_capacity()? min_capacity() : _wanted_capacity);
-        if (valid_ && new_capacity <= capacity_) {
-            set_buffer(memory_, new_capacity); // same or less buffer size (if less, we will only use a portion; deletion will be alright, though)
-        } else {
-            if (memory_) {
-                delete[] memory_;
-                memory_ = nullptr;
-            }
+        if (_layout == memory_layout::mirrored) {
+#if defined(__linux__)
+            new_capacity = std::max(new_capacity, (SIZE_TYPE)sysconf(_SC_PAGESIZE)); // page sizes are powers of 2
+#else
+            return false;
+#endif
+        }
 
-            set_buffer(new uint8_t[new_capacity], new_capacity);
+        if (!mapping_ && valid_ && _layout == layout_ && (new_capacity == capacity_ || (new_capacity < capacity_ && _layout == memory_layout::ring))) {
+            set_buffer(memory_, new_capacity, _layout); // same or less buffer size (if less, we will only use a portion; deletion will be alright, though)
+        } else {
+            free_memory();
+            set_buffer(_layout == memory_layout::mirrored ? map_mirrored(new_capacity) : new uint8_t[new_capacity], new_capacity, _layout);
         }
 
         return valid_;
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::borrow(uint8_t* _memory, uint32_t _capacity) -> bool {
-        if (!_memory || (own_memory_ && memory_)) {
-            return false; // nullptr buffer or 'reserve' called before
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::free_memory() {
+        if (mapping_) {
+#if defined(__linux__)
+            munmap(mapping_, mapping_size_);
+#endif
+            mapping_ = nullptr;
+            memory_ = nullptr;
+            control_ = &local_control_;
+        } else if (memory_) {
+#if defined(__linux__)
+            if (layout_ == memory_layout::mirrored) {
+                munmap(memory_, 2 * (size_t)capacity_);
+            } else
+#endif
+            {
+                delete[] memory_;
+            }
+            memory_ = nullptr;
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::map_mirrored(SIZE_TYPE _capacity) -> uint8_t* {
+        uint8_t* ret = nullptr;
+#if defined(__linux__)
+        /*
+            Reserve 2 x capacity of address space and map the same memory file on both halves
+        */
+        auto fd = memfd_create("transactional-ring-buffer", MFD_CLOEXEC);
+        if (fd == -1) {
+            return nullptr;
+        }
+        if (ftruncate(fd, _capacity) == 0) {
+            auto region = (uint8_t*)mmap(nullptr, 2 * (size_t)_capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (region != MAP_FAILED) {
+                auto lower = mmap(region,             _capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+                auto upper = mmap(region + _capacity, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+                if (lower == region && upper == region + _capacity) {
+                    ret = region;
+                } else {
+                    munmap(region, 2 * (size_t)_capacity);
+                }
+            }
+        }
+        close(fd); // the mappings keep the memory alive
+#else
+        (void)_capacity;
+#endif
+        return ret;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::borrow(uint8_t* _memory, SIZE_TYPE _capacity, memory_layout _layout) -> bool {
+        if (!_memory || (own_memory_ && memory_) || _layout == memory_layout::mirrored) {
+            return false; // nullptr buffer, 'reserve' called before or unsupported layout
         }
 
         valid_ = _capacity >= min_capacity() && !(_capacity & (_capacity - 1)); // check that _capacity is indeed power of 2 and >= than 'min_capacity'
         if (valid_) {
-            set_buffer(_memory, _capacity);
+            set_buffer(_memory, _capacity, _layout);
             own_memory_ = false;
             return true;
         }
         return false;
     }
 
+    // Shared memory / persistence
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::shared_data_offset() -> size_t {
+        // the data starts on the first page after the control block
+#if defined(__linux__)
+        auto page = (size_t)sysconf(_SC_PAGESIZE);
+        return (sizeof(control_block) + page - 1) / page * page;
+#else
+        return sizeof(control_block);
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::map_control(int _fd, SIZE_TYPE _capacity, memory_layout _layout) -> bool {
+#if defined(__linux__)
+        /*
+            An empty object is initialized with '_capacity' / '_layout' (unless '_capacity' is 0). Otherwise the
+            description at its head is validated and the endpoint resumes from the published positions.
+        */
+        static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "shared buffers require lock-free atomics");
+        struct stat info;
+        if (fstat(_fd, &info) != 0) {
+            return false;
+        }
+        auto size = (size_t)info.st_size;
+        auto create = size == 0 && _capacity != 0; // an empty object is being created by someone else: never initialize it on attach
+        if (create) {
+            if (_capacity > max_capacity(_layout)) {
+                return false;
+            }
+            _capacity = round_up(_capacity < min_capacity()? min_capacity() : _capacity);
+            size = shared_data_offset() + _capacity;
+            if (_layout == memory_layout::mirrored || ftruncate(_fd, (off_t)size) != 0) {
+                return false;
+            }
+        } else if (size < shared_data_offset()) {
+            return false;
+        }
+        auto mapping = (uint8_t*)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+
+        if (create) {
+            free_memory();
+            control_ = new (mapping) control_block;
+            control_->version = control_block::VERSION;
+            control_->capacity = _capacity;
+            control_->layout = (uint32_t)_layout;
+            control_->timestamp_size = sizeof(TIMESTAMP_TYPE);
+            control_->size_type_size = sizeof(SIZE_TYPE);
+            mapping_ = mapping;
+            mapping_size_ = size;
+            set_buffer(mapping + shared_data_offset(), _capacity, _layout);
+            control_->magic.store(control_block::MAGIC, std::memory_order_release); // attachable from now on
+            return valid_;
+        }
+
+        // validate the description before trusting anything else in the mapping
+        auto control = reinterpret_cast<control_block*>(mapping);
+        auto ready = control->magic.load(std::memory_order_acquire) == control_block::MAGIC;
+        auto capacity = (SIZE_TYPE)control->capacity;
+        auto layout = (memory_layout)control->layout;
+        if (!ready ||
+            control->version != control_block::VERSION ||
+            control->timestamp_size != sizeof(TIMESTAMP_TYPE) ||
+            control->size_type_size != sizeof(SIZE_TYPE) ||
+            capacity < min_capacity() || (capacity & (capacity - 1)) ||
+            (layout != memory_layout::ring && layout != memory_layout::padded) ||
+            size < shared_data_offset() + capacity) {
+            munmap(mapping, size);
+            return false;
+        }
+
+        free_memory();
+        control_ = control;
+        mapping_ = mapping;
+        mapping_size_ = size;
+        set_buffer(mapping + shared_data_offset(), capacity, layout, true);
+        return valid_;
+#else
+        (void)_fd; (void)_capacity; (void)_layout;
+        return false;
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::create_shared(const char* _name, SIZE_TYPE _wanted_capacity, memory_layout _layout) -> bool {
+#if defined(__linux__)
+        if (!own_memory_ || index_ || data_fd_ != -1 || _layout == memory_layout::mirrored) {
+            return false;
+        }
+        auto fd = shm_open(_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd == -1) {
+            return false;
+        }
+        auto ret = map_control(fd, std::max(_wanted_capacity, SIZE_TYPE(1)), _layout);
+        close(fd); // the mapping keeps the object alive
+        if (!ret) {
+            shm_unlink(_name);
+        }
+        return ret;
+#else
+        (void)_name; (void)_wanted_capacity; (void)_layout;
+        return false;
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::attach_shared(const char* _name) -> bool {
+#if defined(__linux__)
+        if (!own_memory_ || index_ || data_fd_ != -1) {
+            return false;
+        }
+        auto fd = shm_open(_name, O_RDWR, 0);
+        if (fd == -1) {
+            return false;
+        }
+        auto ret = map_control(fd, 0, memory_layout::ring); // never initializes: the creator might be on it
+        close(fd);
+        return ret;
+#else
+        (void)_name;
+        return false;
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::unlink_shared(const char* _name) -> bool {
+#if defined(__linux__)
+        return shm_unlink(_name) == 0;
+#else
+        (void)_name;
+        return false;
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::open_file(const char* _path, SIZE_TYPE _wanted_capacity, memory_layout _layout) -> bool {
+#if defined(__linux__)
+        if (!own_memory_ || index_ || data_fd_ != -1 || _layout == memory_layout::mirrored) {
+            return false;
+        }
+        auto fd = open(_path, O_CREAT | O_RDWR | O_CLOEXEC, 0600);
+        if (fd == -1) {
+            return false;
+        }
+        auto ret = map_control(fd, std::max(_wanted_capacity, SIZE_TYPE(1)), _layout);
+        close(fd);
+        if (ret && !recover()) {
+            free_memory();
+            valid_ = ret = false;
+        }
+        return ret;
+#else
+        (void)_path; (void)_wanted_capacity; (void)_layout;
+        return false;
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::recover() -> bool {
+        /*
+            The published positions must be consistent and every committed record from the consumed position
+            on must have a consistent header. The tail is moved back to the first one that does not (torn
+            write-back of the data pages after a crash of the machine)
+        */
+        auto head = control_->head.load(std::memory_order_acquire);
+        auto tail = control_->tail.load(std::memory_order_acquire);
+        auto position = head;
+        auto oldest = control_->oldest.load(std::memory_order_relaxed);
+        if ((int64_t)(oldest - head) > 0 && (int64_t)(tail - oldest) >= 0) {
+            position = oldest; // overwrite mode dropped the records before it (the consumer might be laps behind)
+        }
+        if ((int64_t)(tail - position) < 0 || tail - position > capacity_) {
+            return false;
+        }
+        if (position != head) {
+            // consume what was dropped: a plain buffer never catches up by itself
+            control_->head.store(position, std::memory_order_release);
+            start_ = head_cache_ = tail_cache_ = position;
+        }
+        while (position != tail) {
+            auto transaction = false;
+            auto size = span_at(position, transaction);
+            if (size == 0 || size > tail - position || (transaction && size < transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>::header_size())) {
+                break;
+            }
+            position += size;
+        }
+        if (position != tail) {
+            control_->tail.store(position, std::memory_order_release);
+            end_ = synced_end_ = position;
+        }
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::set_sync_policy(uint64_t _every_bytes, std::chrono::nanoseconds _every) {
+        sync_every_bytes_ = _every_bytes;
+        sync_every_ = _every;
+        sync_ = _every_bytes != ~0ull || _every != std::chrono::nanoseconds::zero();
+        synced_end_ = end_;
+        synced_at_ = std::chrono::steady_clock::now();
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::sync() -> bool {
+#if defined(__linux__)
+        return mapping_ && msync(mapping_, mapping_size_, MS_SYNC) == 0;
+#else
+        return false;
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::sync_if_due() {
+        if (end_ - synced_end_ >= sync_every_bytes_ ||
+            (sync_every_ != std::chrono::nanoseconds::zero() && std::chrono::steady_clock::now() - synced_at_ >= sync_every_)) {
+            sync();
+            synced_end_ = end_;
+            synced_at_ = std::chrono::steady_clock::now();
+        }
+    }
+
     // Creation of transactions
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::try_read() -> read_transaction<TIMESTAMP_TYPE> {
-        return read_transaction<TIMESTAMP_TYPE>(*this);
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::try_read() -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE> {
+        if (expiry_cutoff_) {
+            auto stats = expire_before(expiry_cutoff_());
+            expired_.count += stats.count;
+            expired_.bytes += stats.bytes;
+        }
+        return read_transaction<TIMESTAMP_TYPE, SIZE_TYPE>(*this);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::try_write(TIMESTAMP_TYPE _timestamp, SIZE_TYPE _min_size) -> write_transaction<TIMESTAMP_TYPE, SIZE_TYPE> {
+        if (pending_count_ && publish_expired()) {
+            flush();
+        }
+        return write_transaction<TIMESTAMP_TYPE, SIZE_TYPE>(*this, _timestamp, _min_size);
+    }
+
+    // Blocking transactions
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    template<typename WAIT_STRATEGY>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::write(TIMESTAMP_TYPE _timestamp, std::chrono::nanoseconds _timeout, SIZE_TYPE _min_size) -> write_transaction<TIMESTAMP_TYPE, SIZE_TYPE> {
+        const auto deadline = std::chrono::steady_clock::now() + _timeout;
+        WAIT_STRATEGY strategy;
+        while (true) {
+            auto wr = try_write(_timestamp, _min_size);
+            if (wr || writing_ || !valid_ || std::chrono::steady_clock::now() >= deadline) {
+                return wr;
+            }
+            strategy.wait(control_->head, head_cache_, parking_ ? &control_->producer_waiters : nullptr, deadline);
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    template<typename WAIT_STRATEGY>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::read(std::chrono::nanoseconds _timeout) -> read_transaction<TIMESTAMP_TYPE, SIZE_TYPE> {
+        const auto deadline = std::chrono::steady_clock::now() + _timeout;
+        WAIT_STRATEGY strategy;
+        while (true) {
+            auto rd = try_read();
+            if (rd || reading_ || !valid_ || std::chrono::steady_clock::now() >= deadline) {
+                return rd;
+            }
+            strategy.wait(control_->tail, tail_cache_, parking_ ? &control_->consumer_waiters : nullptr, deadline);
+        }
+    }
+
+    // Overwrite mode
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::enable_overwrite(bool _enable) {
+        overwrite_ = _enable;
+        head_cache_ = overwrite_ ? control_->oldest.load(std::memory_order_relaxed) : control_->head.load(std::memory_order_acquire);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::lost() const -> uint64_t {
+        return control_->lost.load(std::memory_order_relaxed);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::span_at(uint64_t _position, bool& _transaction) -> SIZE_TYPE {
+        // bytes taken by the transaction or the padding at '_position'
+        auto idx = index_of(_position);
+        _transaction = true;
+        if (layout_ == memory_layout::padded && idx + transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>::header_size() > capacity_) {
+            _transaction = false;
+            return capacity_ - idx;
+        }
+        SIZE_TYPE size;
+        llread(idx, size);
+        if (layout_ == memory_layout::padded && (size & size_traits<SIZE_TYPE>::PADDING_FLAG)) {
+            _transaction = false;
+            return size & ~size_traits<SIZE_TYPE>::PADDING_FLAG;
+        }
+        return size;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::make_room(SIZE_TYPE _wanted) -> SIZE_TYPE {
+        // drop the oldest transactions (never the one being written) until '_wanted' bytes fit
+        auto oldest = head_cache_;
+        auto head = control_->head.load(std::memory_order_relaxed);
+        auto lost = 0u;
+        while (capacity_ - (SIZE_TYPE)(end_ - oldest) < _wanted && oldest != end_) {
+            auto transaction = false;
+            auto size = span_at(oldest, transaction);
+            lost += transaction && oldest >= head ? 1 : 0;
+            oldest += size;
+        }
+
+        if (oldest != head_cache_) {
+            // seqlock-like: the new oldest position must be visible before the memory is reused
+            control_->oldest.store(oldest, std::memory_order_relaxed);
+            control_->lost.store(control_->lost.load(std::memory_order_relaxed) + lost, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            head_cache_ = oldest;
+        }
+        return capacity_ - (SIZE_TYPE)(end_ - oldest);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::catch_up() {
+        auto oldest = control_->oldest.load(std::memory_order_acquire);
+        if ((int64_t)(oldest - start_) > 0) {
+            start_ = oldest;
+            tail_cache_ = control_->tail.load(std::memory_order_acquire); // at least 'oldest'
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::overwritten(uint64_t _position) const -> bool {
+        std::atomic_thread_fence(std::memory_order_acquire); // pairs with the fence in 'make_room'
+        return (int64_t)(control_->oldest.load(std::memory_order_relaxed) - _position) > 0;
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::try_write(TIMESTAMP_TYPE _timestamp) -> write_transaction<TIMESTAMP_TYPE> {
-        return write_transaction<TIMESTAMP_TYPE>(*this, _timestamp);
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::enable_parking(bool _enable) {
+        parking_ = _enable;
+        notify_ = parking_ || data_fd_ != -1;
     }
 
+    // Doorbells
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::enable_doorbells() -> bool {
+#if defined(__linux__)
+        if (mapping_) {
+            return false; // the other side cannot write to our descriptors
+        }
+        if (data_fd_ == -1) {
+            data_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            room_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (data_fd_ == -1 || room_fd_ == -1) {
+                for (auto* fd : { &data_fd_, &room_fd_ }) {
+                    if (*fd != -1) {
+                        close(*fd);
+                        *fd = -1;
+                    }
+                }
+                return false;
+            }
+        }
+        notify_ = true;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::data_eventfd() const -> int {
+        return data_fd_;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::room_eventfd() const -> int {
+        return room_fd_;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::notify(std::atomic<uint64_t>& _position, std::atomic<uint32_t>& _waiters, std::atomic<bool>& _armed, int _fd) {
+        std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the 'fetch_add' in 'park' and the store in 'arm'
+        if (parking_) {
+            wait_strategy::unpark(_position, _waiters);
+        }
+#if defined(__linux__)
+        if (_fd != -1 && _armed.load(std::memory_order_relaxed) && _armed.exchange(false, std::memory_order_relaxed)) {
+            uint64_t one = 1;
+            auto written = ::write(_fd, &one, sizeof(one)); // only fails when the counter would overflow
+            (void)written;
+        }
+#else
+        (void)_armed; (void)_fd;
+#endif
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::arm(std::atomic<bool>& _armed, std::atomic<uint64_t>& _position) -> uint64_t {
+        // arm first and then look again: either we see the publication or the publisher sees the flag
+        if (!_armed.load(std::memory_order_relaxed)) {
+            _armed.store(true, std::memory_order_seq_cst);
+        }
+        return _position.load(std::memory_order_seq_cst);
+    }
+
+    // Group commit
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::set_publish_policy(uint32_t _max_transactions, uint32_t _max_bytes, std::chrono::nanoseconds _max_delay) {
+        flush();
+        publish_count_ = std::max(_max_transactions, 1u);
+        publish_bytes_ = _max_bytes;
+        publish_delay_ = _max_delay;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::flush() {
+        if (pending_count_) {
+            control_->tail.store(end_, std::memory_order_release);
+            pending_count_ = pending_bytes_ = 0;
+            if (notify_) {
+                notify(control_->tail, control_->consumer_waiters, control_->data_armed, data_fd_);
+            }
+            if (sync_) {
+                sync_if_due();
+            }
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::publish_head() {
+        control_->head.store(start_, std::memory_order_release);
+        if (notify_) {
+            notify(control_->head, control_->producer_waiters, control_->room_armed, room_fd_);
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::committed(SIZE_TYPE _size) {
+        // note: with the default policy the first check always succeeds
+        if (++pending_count_ >= publish_count_ || (pending_bytes_ += _size) >= publish_bytes_) {
+            flush();
+        } else if (publish_delay_ != std::chrono::nanoseconds::zero()) {
+            if (pending_count_ == 1) {
+                pending_since_ = std::chrono::steady_clock::now();
+            } else if (publish_expired()) {
+                flush();
+            }
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::publish_expired() const -> bool {
+        return publish_delay_ != std::chrono::nanoseconds::zero() && std::chrono::steady_clock::now() - pending_since_ >= publish_delay_;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::drain(uint32_t _max_count, uint64_t _max_bytes) -> read_batch<TIMESTAMP_TYPE, SIZE_TYPE> {
+        if (expiry_cutoff_) {
+            auto stats = expire_before(expiry_cutoff_());
+            expired_.count += stats.count;
+            expired_.bytes += stats.bytes;
+        }
+        return read_batch<TIMESTAMP_TYPE, SIZE_TYPE>(*this, _max_count, _max_bytes);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::drain_to(int _fd, uint64_t _max_bytes) -> int64_t {
+#if defined(__linux__)
+        if (!valid_ || reading_ || overwrite_) {
+            return -1;
+        }
+        tail_cache_ = control_->tail.load(std::memory_order_acquire); // single snapshot, as 'drain'
+        if (readable() == 0) {
+            return 0;
+        }
+
+        // whole transactions from 'start_', coalesced into at most one segment per side of the end / padding
+        iovec segments[4];
+        auto count = 0;
+        auto append = [&](SIZE_TYPE _idx, SIZE_TYPE _size) {
+            if (count && (uint8_t*)segments[count - 1].iov_base + segments[count - 1].iov_len == &memory_[_idx]) {
+                segments[count - 1].iov_len += _size;
+            } else {
+                segments[count++] = { &memory_[_idx], _size };
+            }
+        };
+        auto position = start_;
+        auto bytes = uint64_t(0);
+        while (position != tail_cache_ && bytes < _max_bytes) {
+            auto transaction = false;
+            auto size = span_at(position, transaction);
+            if (transaction) {
+                auto idx = index_of(position);
+                auto first = idx + size <= linear_size_ ? size : capacity_ - idx;
+                append(idx, first);
+                if (first < size) {
+                    append(0, size - first);
+                }
+                bytes += size;
+            }
+            position += size;
+        }
+
+        auto written = write_all(_fd, segments, count);
+        if (written != bytes) {
+            // error: release the transactions written in full (the file might end with part of the next one)
+            position = start_;
+            bytes = 0;
+            for (;;) {
+                auto transaction = false;
+                auto size = span_at(position, transaction);
+                if (transaction && bytes + size > written) {
+                    break;
+                }
+                bytes += transaction ? size : 0;
+                position += size;
+            }
+            if (bytes == 0) {
+                return -1;
+            }
+        }
+        start_ = position;
+        publish_head();
+        return (int64_t)bytes;
+#else
+        (void)_fd; (void)_max_bytes;
+        return -1;
+#endif
+    }
+
+#if defined(__linux__)
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::write_all(int _fd, iovec* _segments, int _count) -> uint64_t {
+        // 'writev' until everything is written (partial writes on pipes, sockets, signals...)
+        auto ret = uint64_t(0);
+        while (_count) {
+            auto written = writev(_fd, _segments, _count);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return ret;
+            }
+            ret += (uint64_t)written;
+            for (; _count && (size_t)written >= _segments->iov_len; ++_segments, --_count) {
+                written -= _segments->iov_len;
+            }
+            if (_count) {
+                _segments->iov_base = (uint8_t*)_segments->iov_base + written;
+                _segments->iov_len -= written;
+            }
+        }
+        return ret;
+    }
+#endif
+
     // Low level writes and reads (for integrals try to assign instead of memcpy when possible)
+    // note: on mirrored buffers 'linear_size_' is twice the capacity so the split paths are never taken
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE>::llwrite(uint32_t _idx, const uint8_t* _src, uint32_t _size) {
-        if (_idx + _size <= capacity_) {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::llwrite(SIZE_TYPE _idx, const uint8_t* _src, SIZE_TYPE _size) {
+        if (_idx + _size <= linear_size_) {
             memcpy(&memory_[_idx], _src, _size);
         } else {
             auto first_chunk_size = capacity_ - _idx;
@@ -634,10 +2165,10 @@ namespace containers {
         }
     }
 
-    template<typename TIMESTAMP_TYPE>
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
     template<typename T>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::llwrite(uint32_t _idx, const T& _value) -> iff_arith_t<T> {
-        if (_idx + sizeof(T) <= capacity_) {
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::llwrite(SIZE_TYPE _idx, const T& _value) -> iff_arith_t<T> {
+        if (_idx + sizeof(T) <= linear_size_) {
             *((T*)(memory_ + _idx)) = _value; // prefer assignment
         } else {
             auto first_chunk_size = capacity_ - _idx;
@@ -646,16 +2177,16 @@ namespace containers {
         }
     }
 
-    template<typename TIMESTAMP_TYPE>
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
     template<typename T>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::llwrite(uint32_t _idx, const T& _value) -> iff_not_arith_t<T> {
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::llwrite(SIZE_TYPE _idx, const T& _value) -> iff_not_arith_t<T> {
         static_assert(std::is_pod<T>::value, "Non arithmetic values must be POD types");
         llwrite(_idx, (const uint8_t*)&_value, sizeof(T));
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE>::llread(uint32_t _idx, uint8_t* _dest, uint32_t _size) {
-        if ((_idx + _size) <= capacity_) {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::llread(SIZE_TYPE _idx, uint8_t* _dest, SIZE_TYPE _size) {
+        if ((_idx + _size) <= linear_size_) {
             memcpy(_dest, reinterpret_cast<void*>(memory_ + _idx), _size);
         } else {
             const auto first_chunk_size = capacity_ - _idx;
@@ -664,10 +2195,10 @@ namespace containers {
         }
     }
 
-    template<typename TIMESTAMP_TYPE>
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
     template<typename T>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::llread(uint32_t _idx, T& _dest) -> iff_arith_t<T> {
-        if ((_idx + sizeof(T)) <= capacity_) {
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::llread(SIZE_TYPE _idx, T& _dest) -> iff_arith_t<T> {
+        if ((_idx + sizeof(T)) <= linear_size_) {
             _dest = *((T*)(memory_ + _idx)); // prefer assignment
         } else {
             const auto first_chunk_size = capacity_ - _idx;
@@ -676,25 +2207,88 @@ namespace containers {
         }
     }
 
-    template<typename TIMESTAMP_TYPE>
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
     template<typename T>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::llread(uint32_t _idx, T& _dest) -> iff_not_arith_t<T> {
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::llread(SIZE_TYPE _idx, T& _dest) -> iff_not_arith_t<T> {
         static_assert(std::is_pod<T>::value, "Non arithmetic values must be POD types");
-        llread(_idx, (uint8_t*)&_dest, (uint32_t)sizeof(T));
+        llread(_idx, (uint8_t*)&_dest, (SIZE_TYPE)sizeof(T));
     }
 
     // helpers
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::index_of(uint32_t _index) const -> uint32_t {
-        return _index & capacity_mask_;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::index_of(uint64_t _position) const -> SIZE_TYPE {
+        return (SIZE_TYPE)_position & capacity_mask_;
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::round_up(uint32_t _value) const -> uint32_t {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::writable(SIZE_TYPE _wanted) -> SIZE_TYPE {
+        // free bytes according to the cached head; only touch the consumer line when that is not enough
+        auto ret = capacity_ - (SIZE_TYPE)(end_ - head_cache_);
+        if (ret < _wanted) {
+            flush(); // the consumer cannot make room for us with data it does not see
+            if (overwrite_) {
+                return make_room(_wanted); // note: in this mode 'head_cache_' is the oldest position
+            }
+            head_cache_ = control_->head.load(std::memory_order_acquire);
+            ret = capacity_ - (SIZE_TYPE)(end_ - head_cache_);
+            if (ret < _wanted && room_fd_ != -1) {
+                head_cache_ = arm(control_->room_armed, control_->head);
+                ret = capacity_ - (SIZE_TYPE)(end_ - head_cache_);
+            }
+        }
+        return ret;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::pad() {
+        // skip the bytes up to the end and publish them at once, so that the consumer releases them while the
+        // next transaction waits for room at the beginning (explicit marker only when a header fits)
+        auto idx = index_of(end_);
+        auto padding = capacity_ - idx;
+        if (idx + transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>::header_size() <= capacity_) {
+            llwrite(idx, padding | size_traits<SIZE_TYPE>::PADDING_FLAG);
+        }
+        end_ += padding;
+        padding_size_ += padding;
+        ++pending_count_;
+        flush();
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::skip_padding() {
+        auto idx = index_of(start_);
+        if (idx + transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>::header_size() > capacity_) {
+            start_ += capacity_ - idx; // implicit padding (no room for a header)
+        } else {
+            SIZE_TYPE size;
+            llread(idx, size);
+            if (size & size_traits<SIZE_TYPE>::PADDING_FLAG) {
+                start_ += size & ~size_traits<SIZE_TYPE>::PADDING_FLAG;
+            }
+        }
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::readable() -> SIZE_TYPE {
+        // committed bytes according to the cached tail; only touch the producer line when it is empty
+        auto ret = (SIZE_TYPE)(tail_cache_ - start_);
+        if (ret == 0) {
+            tail_cache_ = control_->tail.load(std::memory_order_acquire);
+            ret = (SIZE_TYPE)(tail_cache_ - start_);
+            if (ret == 0 && data_fd_ != -1) {
+                tail_cache_ = arm(control_->data_armed, control_->tail);
+                ret = (SIZE_TYPE)(tail_cache_ - start_);
+            }
+        }
+        return ret;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::round_up(SIZE_TYPE _value) const -> SIZE_TYPE {
         // round-up the size to the next power of 2. ref: https://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2
         auto ret = std::max(_value, min_capacity()) - 1;
-        for (auto i : { 1, 2, 4, 8, 16 }) {
+        for (auto i = 1u; i < sizeof(SIZE_TYPE) * CHAR_BIT; i <<= 1) {
             ret |= ret >> i;
         }
         return ++ret;
@@ -702,28 +2296,222 @@ namespace containers {
 
     // class traits
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline constexpr auto transactional_ring_buffer<TIMESTAMP_TYPE>::min_capacity() -> uint32_t {
-        return (uint32_t)(sizeof (transaction_header<TIMESTAMP_TYPE>::size) + sizeof (transaction_header<TIMESTAMP_TYPE>::timestamp));
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline constexpr auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::min_capacity() -> SIZE_TYPE {
+        return (SIZE_TYPE)(sizeof (transaction_header<TIMESTAMP_TYPE, SIZE_TYPE>::size) + sizeof (transaction_header<TIMESTAMP_TYPE, SIZE_TYPE>::timestamp));
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::size() const -> uint32_t {
-        return size_.load();
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline constexpr auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::max_capacity(memory_layout _layout) -> SIZE_TYPE {
+        return _layout == memory_layout::mirrored ? size_traits<SIZE_TYPE>::PADDING_FLAG >> 1 : size_traits<SIZE_TYPE>::PADDING_FLAG;
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::has_data() const -> bool {
-        return size_.load(std::memory_order_acquire) > 0;
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::size() const -> SIZE_TYPE {
+        return (SIZE_TYPE)(control_->tail.load() - control_->head.load());
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE>::capacity() const -> uint32_t {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::has_data() const -> bool {
+        return control_->tail.load(std::memory_order_acquire) != start_;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::capacity() const -> SIZE_TYPE {
         return capacity_;
     }
 
-    template<typename TIMESTAMP_TYPE>
-    forceinline transactional_ring_buffer<TIMESTAMP_TYPE>::operator bool() const {
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::padding_size() const -> uint64_t {
+        return padding_size_;
+    }
+
+    // Sparse index
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::enable_index(uint32_t _entries, uint32_t _every_transactions, uint32_t _every_bytes) -> bool {
+        if (_entries == 0 || _entries > 0x80000000 || mapping_) {
+            return false; // note: the other side of a shared buffer cannot see our index
+        }
+        auto entries = 1u;
+        while (entries < _entries) {
+            entries <<= 1;
+        }
+        delete[] index_;
+        index_ = new index_entry[entries];
+        index_mask_ = entries - 1;
+        index_every_count_ = index_since_count_ = std::max(_every_transactions, 1u); // the first transaction is always indexed
+        index_every_bytes_ = _every_bytes;
+        index_since_bytes_ = 0;
+        index_end_ = index_start_ = 0;
+        control_->index_count.store(0, std::memory_order_release);
+        return index_ != nullptr;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::index_transaction(SIZE_TYPE _size, TIMESTAMP_TYPE _timestamp) {
+        // note: 'end_' is the position of the transaction being committed
+        if (index_since_count_ >= index_every_count_ || index_since_bytes_ >= index_every_bytes_) {
+            auto& entry = index_[index_end_ & index_mask_];
+            if (index_end_ <= index_mask_ || entry.position.load(std::memory_order_relaxed) < head_cache_) {
+                entry.timestamp = _timestamp;
+                entry.position.store(end_, std::memory_order_release);
+                control_->index_count.store(++index_end_, std::memory_order_release);
+                index_since_count_ = index_since_bytes_ = 0;
+            }
+        }
+        index_since_count_++;
+        index_since_bytes_ += _size;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::seek(TIMESTAMP_TYPE _timestamp) -> bool {
+        if (!valid_ || reading_) {
+            return false;
+        }
+        if (overwrite_) {
+            catch_up(); // the search below never goes back past 'start_', hence it skips entries of dropped data
+        }
+
+        const auto from = start_;
+        tail_cache_ = control_->tail.load(std::memory_order_acquire);
+        auto start = start_;
+
+        /*
+            Binary search of the last published entry older than '_timestamp'. Entries before 'index_start_' or
+            one lap behind 'index_count' might have been overwritten; the rest are intact while they point to
+            unconsumed data (the producer does not reuse their slot until then)
+        */
+        if (index_) {
+            auto count = control_->index_count.load(std::memory_order_acquire);
+            auto lo = std::max(index_start_, count - std::min<uint64_t>(count, index_mask_ + 1ull));
+            auto hi = count;
+            while (lo < hi) { // first entry not consumed (positions grow with the entries)
+                auto mid = lo + (hi - lo) / 2;
+                if (index_[mid & index_mask_].position.load(std::memory_order_acquire) < start) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            index_start_ = lo;
+
+            hi = count;
+            while (lo < hi) {
+                auto mid = lo + (hi - lo) / 2;
+                auto& entry = index_[mid & index_mask_];
+                auto position = entry.position.load(std::memory_order_acquire);
+                if (position < tail_cache_ && entry.timestamp < _timestamp) {
+                    start = position;
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+        }
+
+        // walk the remaining headers
+        start_ = start;
+        auto count = uint64_t{0};
+        auto found = skip_older(_timestamp, count);
+        if (overwrite_ && overwritten(start)) {
+            start_ = from; // headers or index entries might be torn; the next read catches up
+            return false;
+        }
+        publish_head();
+        return found;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::skip_older(TIMESTAMP_TYPE _timestamp, uint64_t& _count) -> bool {
+        /*
+            note: only headers are read; returns true if it stopped at a transaction not older than '_timestamp'.
+            A header that cannot be right (torn by the producer in overwrite mode) undoes the whole walk, as the
+            caller does when the position was overwritten
+        */
+        const auto begin = start_;
+        const auto count = _count;
+        while (start_ != tail_cache_) {
+            if (layout_ == memory_layout::padded) {
+                skip_padding();
+                if (start_ == tail_cache_) {
+                    break;
+                }
+            }
+            SIZE_TYPE size;
+            TIMESTAMP_TYPE timestamp;
+            llread(index_of(start_), size);
+            llread(index_of(start_ + sizeof(size)), timestamp);
+            if (size < transaction_base<TIMESTAMP_TYPE, SIZE_TYPE>::header_size() || size > tail_cache_ - start_) {
+                start_ = begin;
+                _count = count;
+                return false;
+            }
+            if (!(timestamp < _timestamp)) {
+                return true;
+            }
+            start_ += size;
+            ++_count;
+        }
+        return false;
+    }
+
+    // Expiry
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::expire_before(TIMESTAMP_TYPE _cutoff) -> expiry_stats {
+        auto ret = expiry_stats{};
+        if (!valid_ || reading_) {
+            return ret;
+        }
+        if (overwrite_) {
+            catch_up();
+        }
+
+        const auto from = start_;
+        tail_cache_ = control_->tail.load(std::memory_order_acquire);
+        skip_older(_cutoff, ret.count);
+        if (overwrite_ && overwritten(from)) {
+            start_ = from; // headers might be torn; the next read catches up
+            return expiry_stats{};
+        }
+        if (ret.count) {
+            ret.bytes = start_ - from;
+            publish_head();
+        } else {
+            start_ = from; // do not keep skipped padding if nothing expired
+        }
+        return ret;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline void transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::set_expiry_policy(std::function<TIMESTAMP_TYPE()> _cutoff) {
+        expiry_cutoff_ = std::move(_cutoff);
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::expired() const -> expiry_stats {
+        return expired_;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline auto transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::next_timestamp(TIMESTAMP_TYPE& _timestamp) -> bool {
+        if (!valid_ || reading_ || readable() == 0) {
+            return false;
+        }
+        if (layout_ == memory_layout::padded) {
+            skip_padding();
+            if (start_ == tail_cache_) {
+                publish_head(); // only padding
+                return false;
+            }
+        }
+        llread(index_of(start_ + sizeof(transaction_header<TIMESTAMP_TYPE, SIZE_TYPE>::size)), _timestamp);
+        return true;
+    }
+
+    template<typename TIMESTAMP_TYPE, typename SIZE_TYPE>
+    forceinline transactional_ring_buffer<TIMESTAMP_TYPE, SIZE_TYPE>::operator bool() const {
         return valid_;
     }
 
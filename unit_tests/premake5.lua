@@ -60,3 +60,6 @@ project "unit_tests"
 
     files { "*.cpp", "../include/*.h" }
 
+    filter { "system:linux" }
+        links { "rt" }
+
@@ -26,10 +26,26 @@
 #include <limits>
 #include <chrono>
 #include <type_traits>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <atomic>
 #if defined WIN32
 #include <intrin.h>
 #endif
+#if defined(__linux__)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#endif
 #include "transactional-ring-buffer.h"
+#include "transactional-ring-buffer-mpsc.h"
+#include "transactional-ring-buffer-broadcast.h"
+#include "transactional-ring-buffer-merge.h"
+#include "transactional-ring-buffer-sink.h"
+#include "transactional-ring-buffer-elastic.h"
+#include "transactional-ring-buffer-spill.h"
 
 using namespace std;
 
@@ -350,9 +366,95 @@ auto main () -> int {
         END_TEST();
     }
 
+    {
+        qcstudio::containers::transactional_ring_buffer<float> buff;
+        BEGIN_TEST("'reserve_span' + 'advance' across the end of the buffer => two chunks...");
+        verify(CHECK(buff.reserve(32) == true));
+        {
+            auto wr = buff.try_write(0.f);
+            verify(CHECK(wr.push_back(0, 0, 0) == 3)); // 8 + 12 bytes
+        }
+        verify(CHECK((bool)buff.try_read()));
+        {
+            auto wr = buff.try_write(1.f); // header at [20, 28)
+            verify(CHECK(!wr.reserve_span(32)));
+            auto span = wr.reserve_span(12);
+            verify(CHECK(span && span.size() == 12 && span.first_size == 4 && span.second_size == 8));
+            for (auto i = 0u; i < span.first_size; ++i) {
+                span.first[i] = (uint8_t)i;
+            }
+            for (auto i = 0u; i < span.second_size; ++i) {
+                span.second[i] = (uint8_t)(span.first_size + i);
+            }
+            verify(CHECK(!wr.advance(13)));
+            verify(CHECK(wr.advance(12)));
+            verify(CHECK(wr.size() == 12));
+            verify(CHECK(!wr.advance(1))); // spans are consumed by 'advance'
+        }
+        {
+            auto rd = buff.try_read();
+            auto ok = rd.size() == 12;
+            for (auto i = 0u; i < 12; ++i) {
+                auto [value, value_ok] = rd.pop_front<uint8_t>();
+                ok = ok && value_ok && value == i;
+            }
+            verify(CHECK(ok));
+        }
+        END_TEST();
+    }
+
     /*
         Reading data
     */
+    {
+        qcstudio::containers::transactional_ring_buffer<float> buff;
+        BEGIN_TEST("Sized 'pop_front' with lambdas and std::function...");
+        verify(CHECK(buff.reserve(32) == true));
+        {
+            auto wr = buff.try_write(0.f);
+            verify(CHECK(wr.push_back(1, 2, 3) == 3));
+        }
+        {
+            auto rd = buff.try_read();
+            auto sum = 0u, calls = 0u;
+            verify(CHECK(rd.pop_front(4, [&](const uint8_t* _data, uint32_t _size) { sum += _size; calls += *_data; })));
+            verify(CHECK(rd.pop_front(4, std::function<void(const uint8_t*, uint32_t)>())));  // skip
+            verify(CHECK(rd.pop_front(4, std::function<void(const uint8_t*, uint32_t)>([&](const uint8_t* _data, uint32_t _size) { sum += _size; calls += *_data; }))));
+            verify(CHECK(!rd.pop_front(1, [](const uint8_t*, uint32_t) {})));
+            verify(CHECK(sum == 8 && calls == 4));
+        }
+        END_TEST();
+    }
+    {
+        qcstudio::containers::transactional_ring_buffer<float> buff;
+        BEGIN_TEST("'peek' / 'view' alias the ring memory...");
+        verify(CHECK(buff.reserve(32) == true));
+        {
+            auto wr = buff.try_write(0.f);
+            verify(CHECK(wr.push_back(0, 0, 0) == 3));
+        }
+        verify(CHECK((bool)buff.try_read()));
+        {
+            auto wr = buff.try_write(1.f); // header at [20, 28), payload crosses the end
+            verify(CHECK(wr.push_back(42, 7, 8) == 3));
+        }
+        {
+            auto rd = buff.try_read();
+            auto value = rd.peek<int>();
+            verify(CHECK(value && *value == 42));
+            verify(CHECK(rd.peek<int>() == value)); // 'peek' does not consume
+            verify(CHECK(!rd.peek<uint64_t>()));     // crosses the end of the buffer
+            verify(CHECK(!rd.view(13)));
+            auto span = rd.view(12);
+            verify(CHECK(span && span.first == (const uint8_t*)value && span.first_size == 4 && span.second_size == 8));
+            int values[2];
+            memcpy(values, span.second, sizeof(values));
+            verify(CHECK(values[0] == 7 && values[1] == 8));
+            verify(CHECK(!rd.peek<uint8_t>()));
+        }
+        END_TEST();
+    }
+
     {
         qcstudio::containers::transactional_ring_buffer<float> buff;
         BEGIN_TEST("'pop_front' from empty buffer => invalid transacion...");
@@ -362,6 +464,1120 @@ auto main () -> int {
         END_TEST();
     }
 
+    {
+        qcstudio::containers::transactional_ring_buffer<float> buff;
+        BEGIN_TEST("Write / read many laps around the buffer...");
+        verify(CHECK(buff.reserve(32) == true));
+        auto ok = true;
+        for (auto i = 0; i < 100 && ok; ++i) {
+            {
+                auto wr = buff.try_write((float)i);
+                ok = ok && wr && wr.push_back(i, (uint8_t)i) == 2;
+            }
+            {
+                auto rd = buff.try_read();
+                auto [value, value_ok] = rd.pop_front<int>();
+                auto [byte, byte_ok] = rd.pop_front<uint8_t>();
+                ok = ok && rd && rd.timestamp() == (float)i && value_ok && value == i && byte_ok && byte == (uint8_t)i;
+            }
+            ok = ok && buff.size() == 0;
+        }
+        verify(CHECK(ok));
+        END_TEST();
+    }
+
+    /*
+        Mirrored memory layout
+    */
+#if defined(__linux__)
+    {
+        qcstudio::containers::transactional_ring_buffer<float> buff;
+        BEGIN_TEST("'reserve' mirrored buffer => every read is a single chunk...");
+        verify(CHECK(buff.reserve(64, qcstudio::containers::memory_layout::mirrored) == true));
+        verify(CHECK(is_power_of_2(buff.capacity()) && buff.capacity() >= 64));
+
+        uint8_t payload[1000];
+        auto ok = true;
+        for (auto i = 0; i < 100 && ok; ++i) {
+            for (auto j = 0u; j < sizeof(payload); ++j) {
+                payload[j] = (uint8_t)(i + j);
+            }
+            {
+                auto wr = buff.try_write(0.f);
+                ok = ok && wr.push_back(&payload[0], (uint32_t)sizeof(payload));
+            }
+            {
+                auto rd = buff.try_read();
+                auto calls = 0;
+                ok = ok && rd.pop_front((uint32_t)sizeof(payload), [&](const uint8_t* _data, uint32_t _size) {
+                    ++calls;
+                    ok = ok && _size == sizeof(payload) && memcmp(_data, payload, _size) == 0;
+                });
+                ok = ok && calls == 1;
+            }
+        }
+        verify(CHECK(ok));
+        END_TEST();
+    }
+#endif
+
+    /*
+        Padded memory layout
+    */
+    {
+        qcstudio::containers::transactional_ring_buffer<float> buff;
+        BEGIN_TEST("'borrow' padded buffer => transactions never cross the end...");
+        auto buffer = unique_ptr<uint8_t[]>(new uint8_t[256]);
+        verify(CHECK(buff.borrow(buffer.get(), 256, qcstudio::containers::memory_layout::mirrored) == false));
+        verify(CHECK(buff.borrow(buffer.get(), 256, qcstudio::containers::memory_layout::padded) == true));
+
+        uint8_t payload[100];
+        auto ok = true;
+        for (auto i = 0; i < 100 && ok; ++i) {
+            const auto size = (uint32_t)(1 + (i * 37) % sizeof(payload));
+            for (auto j = 0u; j < size; ++j) {
+                payload[j] = (uint8_t)(i + j);
+            }
+            {
+                // pour the data in two steps so that some transactions are relocated
+                auto wr = buff.try_write((float)i);
+                ok = ok && wr.push_back(&payload[0], size / 2) && wr.push_back(&payload[size / 2], size - size / 2);
+            }
+            {
+                auto rd = buff.try_read();
+                auto calls = 0;
+                ok = ok && rd.timestamp() == (float)i && rd.size() == size;
+                ok = ok && rd.pop_front(size, [&](const uint8_t* _data, uint32_t _size) {
+                    ++calls;
+                    ok = ok && _size == size && memcmp(_data, payload, _size) == 0;
+                });
+                ok = ok && calls == 1;
+            }
+            ok = ok && buff.size() == 0;
+        }
+        verify(CHECK(ok));
+        verify(CHECK(buff.padding_size() > 0));
+        END_TEST();
+
+        BEGIN_TEST("Padded buffer takes transactions bigger than the room around the end...");
+        qcstudio::containers::transactional_ring_buffer<float> big;
+        verify(CHECK(big.reserve(256, qcstudio::containers::memory_layout::padded)));
+        uint8_t data[180] = {};
+        big.try_write(0.f).push_back(&data[0], 100); // 108 bytes: the end is 148 bytes away
+        verify(CHECK((bool)big.try_read()));
+        verify(CHECK(!big.try_write(1.f, 180)));                 // the padding is published on its own...
+        verify(CHECK(!big.try_read() && big.size() == 0));       // ...and released by the consumer
+        verify(CHECK(big.try_write(1.f, 180).push_back(&data[0], 180)));
+        verify(CHECK(big.try_read().size() == 180));
+
+        big.try_write(2.f).push_back(&data[0], 100);            // same position, growing across the end
+        verify(CHECK((bool)big.try_read()));
+        {
+            auto wr = big.try_write(3.f);
+            verify(CHECK(wr.push_back(1) && !wr.push_back(&data[0], 170))); // moved to the beginning
+            verify(CHECK(!big.try_read()));
+            verify(CHECK(wr.push_back(&data[0], 170)));
+        }
+        auto rd = big.try_read();
+        auto [first, first_ok] = rd.pop_front<int>();
+        verify(CHECK(first_ok && first == 1 && rd.size() == 174 && rd.timestamp() == 3.f));
+        END_TEST();
+    }
+
+    /*
+        Group commit
+    */
+    {
+        qcstudio::containers::transactional_ring_buffer<float> buff;
+        BEGIN_TEST("Group commit publishes every N transactions / M bytes / on 'flush'...");
+        verify(CHECK(buff.reserve(256) == true));
+        buff.set_publish_policy(3);
+        for (auto i = 0; i < 2; ++i) {
+            auto wr = buff.try_write((float)i);
+            wr.push_back(i);
+        }
+        verify(CHECK(buff.size() == 0 && !buff.try_read()));
+        {
+            auto wr = buff.try_write(2.f);
+            wr.push_back(2);
+        }
+        verify(CHECK(buff.size() == 3 * 12));
+        {
+            auto wr = buff.try_write(3.f);
+            wr.push_back(3);
+        }
+        verify(CHECK(buff.size() == 3 * 12));
+        buff.flush();
+        verify(CHECK(buff.size() == 4 * 12));
+        for (auto rd : buff.drain()) {
+        }
+
+        buff.set_publish_policy(100, 24);
+        {
+            auto wr = buff.try_write(0.f);
+            wr.push_back(0);
+        }
+        verify(CHECK(buff.size() == 0));
+        {
+            auto wr = buff.try_write(0.f);
+            wr.push_back(0);
+        }
+        verify(CHECK(buff.size() == 24));
+        END_TEST();
+
+        BEGIN_TEST("Group commit publishes pending transactions when the buffer looks full...");
+        buff.set_publish_policy(100);
+        auto count = 0u;
+        while (true) {
+            auto wr = buff.try_write(0.f);
+            if (!wr || !wr.push_back(count)) {
+                wr.invalidate();
+                break;
+            }
+            ++count;
+        }
+        verify(CHECK(count > 0 && buff.size() == 24 + count * 12));
+        END_TEST();
+    }
+
+    /*
+        Blocking transactions
+    */
+    {
+        using namespace std::chrono;
+        using namespace qcstudio::containers;
+
+        transactional_ring_buffer<float> buff;
+        BEGIN_TEST("Blocking 'read' / 'write' time out...");
+        verify(CHECK(buff.reserve(32) == true));
+        verify(CHECK(!buff.try_write(0.f, 32)));
+        auto t0 = steady_clock::now();
+        verify(CHECK(!buff.read<wait_strategy::spin_pause>(milliseconds(10))));
+        verify(CHECK(steady_clock::now() - t0 >= milliseconds(10)));
+        {
+            auto wr = buff.write<wait_strategy::yield>(0.f, milliseconds(10), 20);
+            verify(CHECK(wr && wr.push_back(0, 0, 0, 0, 0) == 5));
+        }
+        t0 = steady_clock::now();
+        verify(CHECK(!buff.write<wait_strategy::busy_spin>(0.f, milliseconds(10))));
+        verify(CHECK(steady_clock::now() - t0 >= milliseconds(10)));
+        END_TEST();
+
+        BEGIN_TEST("Blocking 'read' / 'write' with parked threads...");
+        buff.enable_parking();
+        auto producer = thread([&] {
+            for (auto i = 0; i < 1000; ++i) {
+                auto wr = buff.write(0.f, seconds(10), sizeof(i));
+                wr.push_back(i);
+            }
+        });
+        auto ok = true;
+        for (auto i = 0; i < 1001 && ok; ++i) {
+            auto rd = buff.read(seconds(10));
+            auto [value, value_ok] = rd.pop_front<int>();
+            ok = rd && value_ok && value == (i == 0 ? 0 : i - 1);
+        }
+        producer.join();
+        verify(CHECK(ok));
+        END_TEST();
+    }
+
+    /*
+        Batched reads
+    */
+    {
+        qcstudio::containers::transactional_ring_buffer<float> buff;
+        BEGIN_TEST("'drain' publishes the consumed position once...");
+        verify(CHECK(buff.reserve(256) == true));
+        for (auto i = 0; i < 5; ++i) {
+            auto wr = buff.try_write((float)i);
+            wr.push_back(i);
+        }
+        {
+            auto batch = buff.drain(3);
+            verify(CHECK((bool)batch));
+            verify(CHECK(!buff.try_read()));
+            auto expected = 0;
+            for (auto rd : batch) {
+                auto [value, ok] = rd.pop_front<int>();
+                verify(CHECK(ok && value == expected && rd.timestamp() == (float)expected));
+                ++expected;
+                verify(CHECK(buff.size() == 5 * 12)); // nothing published yet
+            }
+            verify(CHECK(expected == 3 && batch.count() == 3 && batch.bytes() == 3 * 12));
+        }
+        verify(CHECK(buff.size() == 2 * 12));
+        END_TEST();
+
+        BEGIN_TEST("'drain' stops at an invalidated transaction...");
+        {
+            auto batch = buff.drain();
+            for (auto rd : batch) {
+                rd.invalidate();
+            }
+            verify(CHECK(batch.count() == 0));
+        }
+        verify(CHECK(buff.size() == 2 * 12));
+        {
+            auto count = 0u;
+            for (auto rd : buff.drain()) {
+                ++count;
+            }
+            verify(CHECK(count == 2 && buff.size() == 0 && !buff.drain()));
+        }
+        END_TEST();
+    }
+
+#if defined(__linux__)
+    /*
+        Doorbells
+    */
+    {
+        qcstudio::containers::transactional_ring_buffer<float> buff;
+        auto rung = [](int _fd) {
+            pollfd pfd = { _fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 0) != 1) {
+                return false;
+            }
+            uint64_t count;
+            return read(_fd, &count, sizeof(count)) == sizeof(count);
+        };
+
+        BEGIN_TEST("Doorbells ring once per empty => non-empty / full => non-full edge...");
+        verify(CHECK(buff.data_eventfd() == -1));
+        verify(CHECK(buff.reserve(32) == true && buff.enable_doorbells()));
+        verify(CHECK(buff.data_eventfd() != -1 && buff.room_eventfd() != -1));
+        buff.try_write(0.f).push_back(1);
+        verify(CHECK(!rung(buff.data_eventfd()))); // nobody saw it empty
+        buff.try_read();
+        verify(CHECK(!buff.try_read()));           // arms the data doorbell
+        buff.try_write(0.f).push_back(2);
+        buff.try_write(0.f).push_back(3);
+        verify(CHECK(rung(buff.data_eventfd()) && !rung(buff.data_eventfd())));
+        verify(CHECK(!buff.try_write(0.f, 16)));   // arms the room doorbell
+        verify(CHECK(!rung(buff.room_eventfd())));
+        buff.try_read();
+        verify(CHECK(rung(buff.room_eventfd())));
+        buff.try_read();
+        verify(CHECK(!rung(buff.room_eventfd())));
+        END_TEST();
+    }
+#endif
+
+    /*
+        Overwrite mode
+    */
+    {
+        qcstudio::containers::transactional_ring_buffer<float> buff;
+        BEGIN_TEST("Overwrite mode keeps the newest transactions...");
+        verify(CHECK(buff.reserve(64) == true));
+        buff.enable_overwrite();
+        auto ok = true;
+        for (auto i = 0; i < 10; ++i) {
+            auto wr = buff.try_write((float)i);
+            ok &= wr && wr.push_back(i);
+        }
+        verify(CHECK(ok && buff.lost() == 5));
+        for (auto i = 5; i < 10; ++i) {
+            auto rd = buff.try_read();
+            auto [value, value_ok] = rd.pop_front<int>();
+            verify(CHECK(value_ok && value == i && !rd.clobbered()));
+        }
+        verify(CHECK(!buff.try_read()));
+        END_TEST();
+
+        BEGIN_TEST("Overwrite mode detects clobbered reads...");
+        verify(CHECK(buff.reserve(256, qcstudio::containers::memory_layout::padded) == true));
+        for (auto i = 0; i < 3; ++i) {
+            buff.try_write((float)i).push_back(i);
+        }
+        {
+            auto rd = buff.try_read();
+            verify(CHECK(rd && rd.timestamp() == 0.f && !rd.clobbered()));
+            for (auto i = 3; i < 30; ++i) {
+                buff.try_write((float)i).push_back(i);
+            }
+            verify(CHECK(rd.clobbered()));
+        }
+        auto first = buff.try_read();
+        verify(CHECK(first && first.timestamp() == 9.f && buff.lost() == 9)); // 21 transactions fit
+        END_TEST();
+    }
+
+    /*
+        Seek
+    */
+    {
+        qcstudio::containers::transactional_ring_buffer<float> buff;
+        const auto fill = [&buff](int _count) {
+            for (auto i = 0; i < _count; ++i) {
+                buff.try_write((float)i).push_back(i);
+            }
+        };
+        const auto next = [&buff]() {
+            auto rd = buff.try_read();
+            auto [value, ok] = rd.pop_front<int>();
+            return ok && rd.timestamp() == (float)value ? value : -1;
+        };
+
+        BEGIN_TEST("'seek' with a sparse index...");
+        verify(CHECK(buff.reserve(1024) && buff.enable_index(4, 3)));
+        fill(20);
+        verify(CHECK(buff.seek(2.f) && next() == 2));
+        verify(CHECK(buff.seek(7.f) && next() == 7 && buff.size() == 12 * 12));
+        verify(CHECK(buff.seek(8.5f) && next() == 9));
+        verify(CHECK(!buff.seek(100.f) && buff.size() == 0 && !buff.try_read()));
+        fill(20); // the index wraps around
+        verify(CHECK(buff.seek(15.f) && next() == 15));
+        END_TEST();
+
+        BEGIN_TEST("'expire_before' and the expiry policy...");
+        verify(CHECK(buff.reserve(256, qcstudio::containers::memory_layout::padded)));
+        fill(10);
+        {
+            auto stats = buff.expire_before(4.f);
+            verify(CHECK(stats.count == 4 && stats.bytes == 4 * 12 && buff.size() == 6 * 12 && next() == 4));
+            stats = buff.expire_before(2.f);
+            verify(CHECK(stats.count == 0 && stats.bytes == 0));
+        }
+        auto cutoff = 8.f;
+        buff.set_expiry_policy([&cutoff] { return cutoff; });
+        verify(CHECK(next() == 8 && buff.expired().count == 3));
+        cutoff = 100.f;
+        verify(CHECK(!buff.drain() && buff.expired().count == 4 && buff.expired().bytes == 4 * 12));
+        buff.set_expiry_policy(nullptr);
+        END_TEST();
+
+        BEGIN_TEST("'expire_before' / 'seek' stop at a header that cannot be right...");
+        {
+            qcstudio::containers::transactional_ring_buffer<float> torn;
+            uint8_t memory[256] = {};
+            verify(CHECK(torn.borrow(memory, sizeof(memory))));
+            for (auto i = 0; i < 4; ++i) {
+                torn.try_write((float)i).push_back(i);
+            }
+            memset(&memory[24], 0, sizeof(uint32_t)); // size of the third record (12 bytes per record)
+            auto stats = torn.expire_before(100.f);
+            verify(CHECK(stats.count == 0 && stats.bytes == 0 && !torn.seek(100.f)));
+            verify(CHECK(torn.try_read().timestamp() == 0.f));
+            verify(CHECK(torn.size() == 3 * 12));
+        }
+        END_TEST();
+
+        BEGIN_TEST("'seek' without index / with a full index / during a read...");
+        verify(CHECK(buff.reserve(1024) && buff.enable_index(2, 1)));
+        fill(20); // only the first 2 are indexed as their slots are not consumed
+        verify(CHECK(buff.seek(11.f) && next() == 11));
+        {
+            auto rd = buff.try_read();
+            verify(CHECK(!buff.seek(15.f)));
+        }
+        qcstudio::containers::transactional_ring_buffer<float> plain;
+        verify(CHECK(plain.reserve(256, qcstudio::containers::memory_layout::padded)));
+        for (auto i = 0; i < 15; ++i) {
+            plain.try_write((float)i).push_back(i);
+            plain.try_read();
+        }
+        for (auto i = 0; i < 10; ++i) {
+            plain.try_write((float)i).push_back(i);
+        }
+        verify(CHECK(plain.seek(6.f) && plain.try_read().timestamp() == 6.f));
+        END_TEST();
+
+        BEGIN_TEST("'seek' after the producer lapped the consumer in overwrite mode...");
+        qcstudio::containers::transactional_ring_buffer<float> recorder, indexed;
+        verify(CHECK(recorder.reserve(256) && indexed.reserve(256, qcstudio::containers::memory_layout::padded) && indexed.enable_index(8, 4)));
+        recorder.enable_overwrite();
+        indexed.enable_overwrite();
+        for (auto i = 0; i < 100; ++i) { // 12 bytes per record: more than four laps
+            recorder.try_write((float)i).push_back(i);
+            indexed.try_write((float)i).push_back(i);
+        }
+        verify(CHECK(recorder.seek(90.f) && recorder.try_read().timestamp() == 90.f));
+        verify(CHECK(indexed.seek(90.f) && indexed.try_read().timestamp() == 90.f));
+        verify(CHECK(indexed.seek(0.f) && indexed.try_read().timestamp() == 91.f)); // only the kept ones
+        verify(CHECK(!recorder.seek(100.f) && !recorder.try_read()));
+        END_TEST();
+    }
+
+    /*
+        Multiple producers
+    */
+    {
+        qcstudio::containers::mpsc_transactional_ring_buffer<float> buff;
+        BEGIN_TEST("MPSC: the consumer stops at the first uncommitted transaction...");
+        verify(CHECK(buff.reserve(128) == true && buff.capacity() == 128));
+        verify(CHECK(!buff.try_write(0.f, 128)));
+        {
+            auto slow = buff.try_write(1.f, 8);
+            verify(CHECK(slow && slow.capacity() >= 8)); // rounded up to the alignment
+            {
+                auto wr = buff.try_write(2.f, 4);
+                verify(CHECK(wr.push_back(2) && !wr.push_back(3)));
+            }
+            verify(CHECK(!buff.try_read() && !buff.has_data()));
+            buff.try_write(3.f, 4).invalidate();
+            slow.push_back(1);
+        }
+        auto expected = 1;
+        while (auto rd = buff.try_read()) {
+            auto [value, ok] = rd.pop_front<int>();
+            verify(CHECK(ok && value == expected && rd.timestamp() == (float)expected && rd.size() == 4));
+            ++expected;
+        }
+        verify(CHECK(expected == 3 && buff.size() == 0));
+        END_TEST();
+
+        BEGIN_TEST("MPSC: concurrent producers around the buffer...");
+        constexpr auto PRODUCERS = 4, COUNT = 10000;
+        vector<thread> producers;
+        for (auto p = 0; p < PRODUCERS; ++p) {
+            producers.emplace_back([&buff, p] {
+                for (auto i = 0; i < COUNT; ) {
+                    if (auto wr = buff.try_write((float)p, 2 * sizeof(int))) {
+                        wr.push_back(p, i++);
+                    } else {
+                        this_thread::yield();
+                    }
+                }
+            });
+        }
+        vector<int> next(PRODUCERS, 0);
+        auto ok = true;
+        for (auto read = 0; read < PRODUCERS * COUNT && ok; ) {
+            if (auto rd = buff.try_read()) {
+                auto [p, p_ok] = rd.pop_front<int>();
+                auto [i, i_ok] = rd.pop_front<int>();
+                ok = p_ok && i_ok && p >= 0 && p < PRODUCERS && next[p]++ == i && rd.timestamp() == (float)p;
+                ++read;
+            } else {
+                this_thread::yield();
+            }
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        verify(CHECK(ok && !buff.try_read()));
+        END_TEST();
+
+        BEGIN_TEST("MPSC: a transaction bigger than half the buffer after the middle...");
+        qcstudio::containers::mpsc_transactional_ring_buffer<float> big;
+        verify(CHECK(big.reserve(1024)));
+        uint8_t payload[600] = {};
+        {
+            auto wr = big.try_write(1.f, 508); // 520 bytes claimed: the tail stops past the middle
+            verify(CHECK(wr.push_back(&payload[0], 508)));
+        }
+        verify(CHECK((bool)big.try_read()));
+        verify(CHECK(big.size() == 0));
+        for (auto i = 0u; i < sizeof(payload); ++i) {
+            payload[i] = (uint8_t)i;
+        }
+        verify(CHECK(!big.try_write(2.f, sizeof(payload)))); // only the bytes up to the end are claimed (as padding)
+        verify(CHECK(!big.try_read() && big.size() == 0));   // the consumer skips them
+        {
+            auto wr = big.try_write(2.f, sizeof(payload));
+            verify(CHECK(wr && wr.push_back(&payload[0], sizeof(payload))));
+        }
+        {
+            auto rd = big.try_read();
+            auto data = rd.view(sizeof(payload));
+            verify(CHECK(rd.timestamp() == 2.f && data && data.first_size == sizeof(payload) && memcmp(data.first, payload, sizeof(payload)) == 0));
+        }
+        verify(CHECK(!big.try_read() && big.size() == 0));
+        END_TEST();
+    }
+
+    /*
+        Broadcast
+    */
+    {
+        qcstudio::containers::broadcast_transactional_ring_buffer<float> buff;
+        BEGIN_TEST("Broadcast: every reader sees every transaction; the slowest one gates the producer...");
+        verify(CHECK(buff.reserve(64) == true && buff.capacity() == 64));
+        auto fast = buff.subscribe();
+        auto slow = buff.subscribe();
+        verify(CHECK(fast && slow && buff.readers() == 2));
+        auto written = 0;
+        while (auto wr = buff.try_write((float)written, sizeof(int))) {
+            wr.push_back(written++);
+        }
+        verify(CHECK(written == 64 / 12));
+        for (auto i = 0; i < written; ++i) {
+            auto rd = fast.try_read();
+            auto [value, ok] = rd.pop_front<int>();
+            verify(CHECK(ok && value == i && rd.timestamp() == (float)i));
+        }
+        verify(CHECK(!fast.try_read() && !buff.try_write(0.f, sizeof(int))));
+        {
+            auto rd = slow.try_read();
+            auto [value, ok] = rd.pop_front<int>();
+            verify(CHECK(ok && value == 0));
+        }
+        verify(CHECK((bool)buff.try_write(0.f, sizeof(int))));
+        slow.unsubscribe();
+        verify(CHECK(buff.readers() == 1 && !slow.try_read()));
+        END_TEST();
+
+        BEGIN_TEST("Broadcast: concurrent readers...");
+        constexpr auto READERS = 3, COUNT = 10000;
+        fast.unsubscribe();
+        verify(CHECK(buff.reserve(256) == true));
+        vector<int> received(READERS, 0);
+        atomic<int> subscribed = 0;
+        vector<thread> readers;
+        for (auto r = 0; r < READERS; ++r) {
+            readers.emplace_back([&, r] {
+                auto reader = buff.subscribe();
+                ++subscribed;
+                while (received[r] < COUNT) {
+                    if (auto rd = reader.try_read()) {
+                        auto [value, ok] = rd.pop_front<int>();
+                        if (!ok || value != received[r]++) {
+                            return;
+                        }
+                    } else {
+                        this_thread::yield();
+                    }
+                }
+            });
+        }
+        while (subscribed < READERS) {
+            this_thread::yield();
+        }
+        for (auto i = 0; i < COUNT; ) {
+            if (auto wr = buff.try_write((float)i)) {
+                wr.push_back(i++);
+            } else {
+                this_thread::yield();
+            }
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        verify(CHECK(received == vector<int>(READERS, COUNT) && buff.readers() == 0));
+        END_TEST();
+    }
+
+    /*
+        Merge reader
+    */
+    {
+        using namespace std::chrono;
+        qcstudio::containers::transactional_ring_buffer<float> a, b, c;
+        qcstudio::containers::merge_reader<float> merge;
+        BEGIN_TEST("Merge reader hands out transactions in timestamp order...");
+        verify(CHECK(a.reserve(256) && b.reserve(256) && c.reserve(256, qcstudio::containers::memory_layout::padded)));
+        verify(CHECK(merge.add(a) && merge.add(b) && merge.add(c) && merge.size() == 3));
+        for (auto ts : { 1.f, 4.f, 5.f, 9.f }) {
+            a.try_write(ts).push_back(0);
+        }
+        for (auto ts : { 2.f, 3.f, 9.f }) {
+            b.try_write(ts).push_back(1);
+        }
+        verify(CHECK(!merge.try_read())); // 'c' is empty and could still get older data
+        for (auto ts : { 0.f, 6.f }) {
+            c.try_write(ts).push_back(2);
+        }
+        auto last = -1.f;
+        auto count = 0;
+        auto ok = true;
+        while (auto rd = merge.try_read()) {
+            auto [source, source_ok] = rd.pop_front<int>();
+            ok &= source_ok && source == (int)merge.source() && rd.timestamp() >= last;
+            last = rd.timestamp();
+            ++count;
+        }
+        verify(CHECK(ok && count == 7 && last == 6.f)); // 'c' is empty again
+        END_TEST();
+
+        BEGIN_TEST("Merge reader with a watermark...");
+        merge.set_max_lag(milliseconds(10));
+        for (auto expected_source : { 0u, 1u }) {
+            verify(CHECK(!merge.try_read())); // the buffers that just got empty hold back the output
+            this_thread::sleep_for(milliseconds(10));
+            auto rd = merge.try_read();
+            verify(CHECK(rd && rd.timestamp() == 9.f && merge.source() == expected_source));
+        }
+        END_TEST();
+
+        BEGIN_TEST("Merge reader with many idle buffers past the watermark...");
+        qcstudio::containers::transactional_ring_buffer<float> idle[8], active;
+        qcstudio::containers::merge_reader<float> wide;
+        wide.set_max_lag(milliseconds(1));
+        for (auto& buffer : idle) {
+            verify(CHECK(buffer.reserve(256) && wide.add(buffer)));
+        }
+        verify(CHECK(active.reserve(1024) && wide.add(active)));
+        for (auto ts = 10; ts < 30; ++ts) {
+            active.try_write((float)ts).push_back(8);
+        }
+        this_thread::sleep_for(milliseconds(2));
+        verify(CHECK(wide.try_read() && wide.source() == 8)); // the idle buffers no longer hold back the output
+        idle[5].try_write(0.f).push_back(5); // late: handed out once probed, within a round of the idle ones
+        auto late_at = -1;
+        count = 0;
+        ok = true;
+        for (auto round = 0; round < 2; ++round) {
+            while (auto rd = wide.try_read()) {
+                auto [source, source_ok] = rd.pop_front<int>();
+                ok &= source_ok && source == (int)wide.source();
+                late_at = source == 5 ? count : late_at;
+                ++count;
+            }
+            this_thread::sleep_for(milliseconds(2)); // 'idle[5]' just got empty again and held back the output
+        }
+        verify(CHECK(ok && count == 20 && late_at >= 0 && late_at < 8));
+        idle[3].try_write(200.f).push_back(3); // nothing else to read: every idle buffer is probed
+        auto rd = wide.try_read();
+        verify(CHECK(rd && wide.source() == 3 && rd.timestamp() == 200.f));
+        END_TEST();
+    }
+
+#if defined(__linux__)
+    /*
+        Shared memory
+    */
+    {
+        using namespace std::chrono;
+        using namespace qcstudio::containers;
+        auto name = "/trb-unit-tests-" + to_string(getpid());
+        transactional_ring_buffer<float> producer, consumer;
+        transactional_ring_buffer<double> wrong;
+        transactional_ring_buffer<float, uint64_t> wide;
+
+        BEGIN_TEST("Shared buffers: create / attach / resume...");
+        verify(CHECK(!consumer.attach_shared(name.c_str())));
+        {
+            struct stat info;
+            auto empty = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600); // as a creator leaves it before sizing it
+            verify(CHECK(empty != -1 && !consumer.attach_shared(name.c_str())));
+            verify(CHECK(fstat(empty, &info) == 0 && info.st_size == 0));           // untouched
+            close(empty);
+            shm_unlink(name.c_str());
+        }
+        verify(CHECK(producer.create_shared(name.c_str(), 1000, memory_layout::padded) && producer.capacity() == 1024));
+        verify(CHECK(!consumer.create_shared(name.c_str(), 1024)));
+        verify(CHECK(!wrong.attach_shared(name.c_str())));  // timestamp size mismatch
+        verify(CHECK(!wide.attach_shared(name.c_str())));   // size type mismatch
+        verify(CHECK(!producer.enable_doorbells()));
+        producer.try_write(1.f).push_back(1);
+        verify(CHECK(consumer.attach_shared(name.c_str()) && consumer.capacity() == 1024));
+        producer.try_write(2.f).push_back(2);
+        {
+            auto rd = consumer.try_read();
+            auto [value, ok] = rd.pop_front<int>();
+            verify(CHECK(ok && value == 1 && rd.timestamp() == 1.f));
+        }
+        {
+            transactional_ring_buffer<float> restarted;  // resumes after the consumed transaction
+            verify(CHECK(restarted.attach_shared(name.c_str())));
+            auto rd = restarted.try_read();
+            auto [value, ok] = rd.pop_front<int>();
+            verify(CHECK(ok && value == 2));
+        }
+        verify(CHECK(consumer.attach_shared(name.c_str()) && !consumer.try_read()));
+        END_TEST();
+
+        BEGIN_TEST("Shared buffers: producer and consumer processes...");
+        constexpr auto COUNT = 10000;
+        if (auto child = fork(); child == 0) {
+            transactional_ring_buffer<float> endpoint;
+            auto ok = endpoint.attach_shared(name.c_str());
+            for (auto i = 0; ok && i < COUNT; ++i) {
+                while (!endpoint.write(0.f, milliseconds(1)).push_back(i)) {}
+            }
+            _exit(ok ? 0 : 1);
+        } else {
+            auto ok = child != -1, in_order = true, exited = false;
+            auto status = 0;
+            for (auto expected = 0; ok && expected < COUNT;) {
+                if (auto rd = consumer.read(milliseconds(1))) {
+                    auto [value, read_ok] = rd.pop_front<int>();
+                    in_order &= read_ok && value == expected++;
+                } else if (exited) {
+                    ok = false; // the child is gone (it failed to attach or died): nothing else is coming
+                } else {
+                    exited = waitpid(child, &status, WNOHANG) == child;
+                }
+            }
+            exited = exited || (ok && waitpid(child, &status, 0) == child);
+            verify(CHECK(ok && exited && WIFEXITED(status) && WEXITSTATUS(status) == 0 && in_order));
+        }
+        verify(CHECK(transactional_ring_buffer<float>::unlink_shared(name.c_str())));
+        verify(CHECK(!consumer.attach_shared(name.c_str())));
+        END_TEST();
+    }
+
+    /*
+        Persistence
+    */
+    {
+        using namespace qcstudio::containers;
+        auto path = "/tmp/trb-unit-tests-" + to_string(getpid());
+        auto read_int = [](transactional_ring_buffer<float>& _buff) {
+            auto rd = _buff.try_read();
+            auto [value, ok] = rd.pop_front<int>();
+            return ok ? value : -1;
+        };
+
+        BEGIN_TEST("Persistent buffers resume after a restart and discard a torn tail...");
+        {
+            transactional_ring_buffer<float> buff;
+            verify(CHECK(buff.open_file(path.c_str(), 1024) && buff.capacity() == 1024));
+            buff.set_sync_policy(0); // every publication
+            for (auto i : { 1, 2, 3, 4 }) {
+                buff.try_write((float)i).push_back(i);
+            }
+            verify(CHECK(read_int(buff) == 1));
+        }
+        {
+            transactional_ring_buffer<double> wrong;
+            verify(CHECK(!wrong.open_file(path.c_str(), 1024)));
+            transactional_ring_buffer<float> buff;
+            verify(CHECK(buff.open_file(path.c_str(), 64) && buff.capacity() == 1024 && buff.size() == 36));
+            verify(CHECK(read_int(buff) == 2 && buff.sync()));
+        }
+        {
+            // tear the header of the last record (position 36, 12 bytes per record)
+            auto fd = open(path.c_str(), O_RDWR);
+            uint32_t garbage = 0;
+            verify(CHECK(pwrite(fd, &garbage, sizeof(garbage), sysconf(_SC_PAGESIZE) + 36) == sizeof(garbage)));
+            close(fd);
+            transactional_ring_buffer<float> buff;
+            verify(CHECK(buff.open_file(path.c_str(), 1024) && buff.size() == 12));
+            verify(CHECK(read_int(buff) == 3 && !buff.try_read()));
+            buff.try_write(5.f).push_back(5);
+            verify(CHECK(read_int(buff) == 5));
+        }
+        unlink(path.c_str());
+        END_TEST();
+
+        BEGIN_TEST("Persistent buffers in overwrite mode resume after the producer lapped the consumer...");
+        for (auto overwrite : { true, false }) { // reopened in overwrite mode or as a plain buffer
+            unlink(path.c_str());
+            {
+                transactional_ring_buffer<float> buff;
+                verify(CHECK(buff.open_file(path.c_str(), 1024)));
+                buff.enable_overwrite();
+                for (auto i = 0; i < 200; ++i) { // 12 bytes per record: more than two laps
+                    buff.try_write((float)i).push_back(i);
+                }
+                verify(CHECK(buff.lost() > 100));
+            }
+            {
+                transactional_ring_buffer<float> buff;
+                verify(CHECK(buff.open_file(path.c_str(), 1024)));
+                if (overwrite) {
+                    buff.enable_overwrite();
+                }
+                verify(CHECK(buff.size() <= buff.capacity()));
+                auto first = read_int(buff), read = 1, last = first;
+                for (auto value = read_int(buff); value != -1 && read <= 1024 / 12; value = read_int(buff), ++read) {
+                    verify(CHECK(value == last + 1));
+                    last = value;
+                }
+                verify(CHECK(first == (int)buff.lost() && last == 199 && read == 200 - first));
+            }
+        }
+        unlink(path.c_str());
+        END_TEST();
+    }
+
+    /*
+        Direct I/O on transactions
+    */
+    {
+        using namespace qcstudio::containers;
+        transactional_ring_buffer<float> buff;
+        int in[2], out[2];
+        auto ok = buff.reserve(32) && pipe(in) == 0 && pipe(out) == 0 && fcntl(in[0], F_SETFL, O_NONBLOCK) == 0;
+        const char message[] = "hello, ring!"; // 13 bytes
+
+        BEGIN_TEST("'read_from' / 'write_to' move data between descriptors and the ring without copies...");
+        buff.try_write(0.f).push_back(uint64_t(0));
+        buff.try_read(); // the next transaction crosses the end of the buffer
+        {
+            auto wr = buff.try_write(1.f);
+            verify(CHECK(ok && wr.read_from(in[0], 64) == -1 && errno == EAGAIN && wr.size() == 0));
+            verify(CHECK(write(in[1], message, sizeof(message)) == sizeof(message)));
+            verify(CHECK(wr.read_from(in[0], 64) == sizeof(message) && wr.size() == sizeof(message)));
+            verify(CHECK(write(in[1], message, sizeof(message)) == sizeof(message)));
+            verify(CHECK(wr.read_from(in[0], 64) == 32 - 8 - 13)); // only the free room
+            verify(CHECK(wr.read_from(in[0], 64) == -1 && errno == ENOBUFS));
+        }
+        {
+            char received[sizeof(message)] = {};
+            auto rd = buff.try_read();
+            verify(CHECK(rd.write_to(out[1], 64) == -1 && rd.write_to(out[1], sizeof(message)) == sizeof(message)));
+            verify(CHECK(read(out[0], received, sizeof(received)) == sizeof(received) && !memcmp(received, message, sizeof(message))));
+            verify(CHECK(rd.write_to(out[1]) == 11 && rd.write_to(out[1]) == 0));
+        }
+        char rest[11];
+        verify(CHECK(read(in[0], rest, 2) == 2 && read(out[0], rest, 11) == 11)); // what was left in the pipes above
+        buff.try_write(2.f).push_back(uint64_t(0)); // 16 bytes
+        {
+            auto wr = buff.try_write(3.f); // 8 bytes of room...
+            verify(CHECK(buff.try_read() && write(in[1], message, sizeof(message)) == sizeof(message))); // ...and 16 more
+            verify(CHECK(wr.read_from(in[0], 0xFFffFFff) == sizeof(message))); // "as much as fits"
+        }
+        {
+            char received[sizeof(message)] = {};
+            auto rd = buff.try_read();
+            verify(CHECK(rd.size() == sizeof(message) && rd.write_to(out[1]) == sizeof(message)));
+            verify(CHECK(read(out[0], received, sizeof(received)) == sizeof(received) && !memcmp(received, message, sizeof(message))));
+        }
+        for (auto fd : { in[0], in[1], out[0], out[1] }) {
+            close(fd);
+        }
+        END_TEST();
+    }
+
+    /*
+        Disk sink
+    */
+    {
+        using namespace std::chrono;
+        using namespace qcstudio::containers;
+        transactional_ring_buffer<float> a, b;
+        disk_sink<float> sink;
+        int fds[2];
+        auto ok = a.reserve(256) && b.reserve(256, memory_layout::padded) && pipe(fds) == 0 && fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0;
+
+        BEGIN_TEST("Disk sink writes whole transactions, around the end and skipping the padding...");
+        verify(CHECK(ok && !sink.start() && sink.add(a, fds[1]) && sink.add(b, fds[1]) && !sink.add(b, -1)));
+        verify(CHECK(sink.start() && !sink.start()));
+        constexpr auto COUNT = 500;
+        for (auto i = 0; i < COUNT; ++i) {
+            auto& buff = i % 2 ? b : a;
+            while (!buff.write<wait_strategy::yield>((float)i, milliseconds(1)).push_back(i)) {}
+        }
+        sink.stop();
+
+        // every record is a header (size, timestamp) and an int; the buffers are interleaved but each one is in order
+        vector<uint8_t> file(COUNT * 12 + 1);
+        auto size = read(fds[0], file.data(), file.size());
+        int next[2] = { 0, 1 };
+        auto in_order = size == COUNT * 12 && sink.written() == (uint64_t)size && !sink.failed();
+        for (auto offset = 0; in_order && offset < size; offset += 12) {
+            uint32_t record_size;
+            float timestamp;
+            int value;
+            memcpy(&record_size, &file[offset], 4);
+            memcpy(&timestamp, &file[offset + 4], 4);
+            memcpy(&value, &file[offset + 8], 4);
+            in_order = record_size == 12 && value == next[value % 2] && timestamp == (float)value;
+            next[value % 2] += 2;
+        }
+        verify(CHECK(in_order && next[0] == COUNT && next[1] == COUNT + 1));
+        close(fds[0]);
+        close(fds[1]);
+        END_TEST();
+
+        BEGIN_TEST("Disk sink stops while the producer keeps committing...");
+        transactional_ring_buffer<float> busy;
+        disk_sink<float> busy_sink;
+        auto null = open("/dev/null", O_WRONLY);
+        verify(CHECK(busy.reserve(4096) && busy_sink.add(busy, null) && busy_sink.start(1 << 20, microseconds(1))));
+        atomic<bool> producing = true;
+        auto producer = thread([&] {
+            for (auto i = 0; producing.load(); ++i) {
+                if (!busy.try_write((float)i).push_back(i)) {
+                    this_thread::yield();
+                }
+            }
+        });
+        this_thread::sleep_for(milliseconds(10));
+        busy_sink.stop(); // returns although the buffer never stays empty
+        producing = false;
+        producer.join();
+        verify(CHECK(busy_sink.written() > 0 && !busy_sink.failed()));
+        close(null);
+        END_TEST();
+
+        BEGIN_TEST("'drain_to' keeps the transactions not written in full when a write fails...");
+        transactional_ring_buffer<float> full;
+        int small[2];
+        verify(CHECK(full.reserve(16384) && pipe(small) == 0 && fcntl(small[1], F_SETFL, O_NONBLOCK) == 0));
+        auto room = fcntl(small[1], F_SETPIPE_SZ, 4096); // the page size at least
+        for (auto i = 0; i < 1000; ++i) {
+            full.try_write((float)i).push_back(i);
+        }
+        auto drained = full.drain_to(small[1]); // a partial write and then EAGAIN
+        verify(CHECK(room > 0 && drained == room / 12 * 12 && full.size() == 12000 - drained && full.drain_to(small[1]) == -1));
+        vector<uint8_t> sink_side(room);
+        verify(CHECK(read(small[0], sink_side.data(), room) == room));
+        int first;
+        {
+            auto rd = full.try_read(); // nothing was consumed past the whole transactions written
+            first = rd.pop_front<int>().first;
+        }
+        verify(CHECK(first == room / 12));
+        close(small[0]);
+        close(small[1]);
+        END_TEST();
+    }
+#endif
+
+    /*
+        Elastic buffer
+    */
+    {
+        qcstudio::containers::elastic_transactional_ring_buffer<float> buff;
+
+        BEGIN_TEST("Elastic buffer chains segments when full and recycles them...");
+        verify(CHECK(!buff && buff.reserve(32, 3) && buff && buff.capacity() == 32 && buff.segments() == 1));
+        auto written = 0;
+        while (buff.try_write((float)written, sizeof(int)).push_back(written)) { // 12 bytes per transaction
+            ++written;
+        }
+        verify(CHECK(written == 6 && buff.segments() == 3)); // 2 per segment
+        {
+            auto wr = buff.try_write(0.f);
+            verify(CHECK(!buff.try_write(0.f))); // never grows with a transaction in progress
+            wr.invalidate();
+        }
+        auto read = 0, ok = 1;
+        while (auto rd = buff.try_read()) {
+            auto [value, valid] = rd.pop_front<int>();
+            ok &= valid && value == (read == 6 ? 100 : read);
+            if (++read == 3) {
+                ok &= buff.try_write(100.f, sizeof(int)).push_back(100); // the drained segment is recycled
+            }
+        }
+        verify(CHECK(ok && read == 7 && buff.segments() == 3));
+        buff.trim();
+        verify(CHECK(buff.segments() == 1 && !buff.try_read()));
+        END_TEST();
+
+        BEGIN_TEST("Elastic buffer resized while it holds data...");
+        verify(CHECK(buff.reserve(32, 1)));
+        auto value = 0;
+        for (; value < 2; ++value) {
+            buff.try_write(0.f, sizeof(int)).push_back(value);
+        }
+        verify(CHECK(!buff.try_write(0.f, sizeof(int)) && buff.resize(128) && buff.capacity() == 128 && buff.segments() == 2));
+        for (; value < 10; ++value) {
+            verify(CHECK(buff.try_write(0.f, sizeof(int)).push_back(value)));
+        }
+        read = 0, ok = 1;
+        while (auto rd = buff.try_read()) {
+            auto [data, valid] = rd.pop_front<int>();
+            ok &= valid && data == read++;
+        }
+        verify(CHECK(ok && read == 10 && buff.segments() == 1)); // the old segment is freed
+        END_TEST();
+    }
+
+#if defined(__linux__)
+    /*
+        Spilling buffer
+    */
+    {
+        qcstudio::containers::spilling_transactional_ring_buffer<float> buff;
+        auto path = "/tmp/trb-unit-tests-spill-" + to_string(getpid());
+        auto read_all = [&buff](int _until, int& _next) {
+            auto ok = true;
+            for (auto attempts = 0; _next < _until && attempts < 100000; ++attempts) {
+                if (auto rd = buff.try_read()) {
+                    auto [value, valid] = rd.pop_front<int>();
+                    ok &= valid && value == _next++;
+                } else {
+                    this_thread::yield(); // spilled data on its way to the file
+                }
+            }
+            return ok && _next == _until;
+        };
+
+        BEGIN_TEST("Spilling buffer keeps the order across memory and the spill file...");
+        verify(CHECK(buff.reserve(64, path.c_str(), 256) && buff.capacity() == 64));
+        auto written = 0, next = 0;
+        for (; written < 20; ++written) {
+            verify(CHECK(buff.try_write((float)written, sizeof(int)).push_back(written)));
+        }
+        verify(CHECK(read_all(10, next)));
+        for (; written < 30; ++written) {  // to memory or to the file, depending on how much was loaded back
+            verify(CHECK(buff.try_write((float)written, sizeof(int)).push_back(written)));
+        }
+        verify(CHECK(read_all(30, next) && buff.spilled() >= 12 * (20 - 64 / 12)));
+        auto spilled = buff.spilled();
+        for (; written < 33; ++written) {  // back to memory
+            verify(CHECK(buff.try_write((float)written, sizeof(int)).push_back(written)));
+        }
+        verify(CHECK(read_all(33, next) && !buff.try_read() && buff.spilled() == spilled));
+        unlink(path.c_str());
+        END_TEST();
+    }
+#endif
+
+    /*
+        64-bit sizes
+    */
+    {
+        using namespace qcstudio::containers;
+        transactional_ring_buffer<float, uint64_t> buff;
+
+        BEGIN_TEST("64-bit sizes: same transactions with wider headers...");
+        verify(CHECK(transaction_base<float, uint64_t>::header_size() == transaction_base<float>::header_size() + 4));
+        verify(CHECK(buff.reserve(200, memory_layout::padded) && buff.capacity() == 256));
+        auto ok = true;
+        for (auto i = 0; i < 100 && ok; ++i) {
+            {
+                auto wr = buff.try_write((float)i);
+                ok = ok && wr.push_back(i) && wr.push_back((uint64_t)i << 40);
+            }
+            auto rd = buff.try_read();
+            auto [low, low_ok] = rd.pop_front<int>();
+            auto [high, high_ok] = rd.pop_front<uint64_t>();
+            ok = ok && rd.size() == sizeof(int) + sizeof(uint64_t) && low_ok && low == i && high_ok && high == (uint64_t)i << 40;
+        }
+        verify(CHECK(ok && buff.size() == 0 && buff.padding_size() > 0));
+        END_TEST();
+
+        BEGIN_TEST("64-bit sizes: elastic and spilling buffers...");
+        elastic_transactional_ring_buffer<float, uint64_t> chained;
+        verify(CHECK(chained.reserve(32, 4) && chained.capacity() == 32));
+        for (auto i = 0; i < 6; ++i) { // 2 per segment
+            verify(CHECK(chained.try_write((float)i, sizeof(int)).push_back(i)));
+        }
+        auto read = 0;
+        while (auto rd = chained.try_read()) {
+            auto [value, valid] = rd.pop_front<int>();
+            ok = ok && valid && value == read++;
+        }
+        verify(CHECK(ok && read == 6 && chained.segments() == 3));
+#if defined(__linux__)
+        spilling_transactional_ring_buffer<float, uint64_t> spilling;
+        auto path = "/tmp/trb-unit-tests-spill64-" + to_string(getpid());
+        verify(CHECK(spilling.reserve(64, path.c_str(), 256)));
+        for (auto i = 0; i < 20; ++i) {
+            verify(CHECK(spilling.try_write((float)i, sizeof(int)).push_back(i)));
+        }
+        read = 0;
+        for (auto attempts = 0; read < 20 && attempts < 100000; ++attempts) {
+            if (auto rd = spilling.try_read()) {
+                auto [value, valid] = rd.pop_front<int>();
+                ok = ok && valid && value == read++;
+            } else {
+                this_thread::yield(); // spilled data on its way to the file
+            }
+        }
+        verify(CHECK(ok && read == 20 && spilling.spilled() > 0));
+        unlink(path.c_str());
+#endif
+        END_TEST();
+
+        BEGIN_TEST("32-bit sizes reject capacities that cannot be rounded up...");
+        transactional_ring_buffer<float> narrow;
+        elastic_transactional_ring_buffer<float> elastic;
+        broadcast_transactional_ring_buffer<float> broadcast;
+        verify(CHECK(transactional_ring_buffer<float>::max_capacity() == 0x80000000u && transactional_ring_buffer<float>::max_capacity(memory_layout::mirrored) == 0x40000000u));
+        verify(CHECK(!narrow.reserve(0x80000001u) && !narrow.reserve(0x40000001u, memory_layout::mirrored) && !narrow));
+        verify(CHECK(!elastic.reserve(0xFFFFFFFFu, 4) && !broadcast.reserve(0x80000001u)));
+        verify(CHECK(transactional_ring_buffer<float, uint64_t>::max_capacity() == 0x8000000000000000ull));
+        END_TEST();
+    }
+
     /*
         TODO: std::move transactions around
     */